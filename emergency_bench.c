@@ -0,0 +1,384 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "emergency_bench.h"
+#include "emergency_module.h"
+#include "emergency_severity.h"
+#include "emergency_scan.h"
+#include "emergency_pool.h"
+#include "emergency_timing.h"
+#include "emergency_debounce.h"
+
+/*
+ * Emergency Module benchmark harness.
+ *
+ * Micro cases run BENCH_WARMUP + BENCH_REPETITIONS passes over BENCH_NODES
+ * nodes. Every pass re-prepares the nodes outside the timed region and times
+ * the operation in chunks of BENCH_CHUNK calls; median and p99 are taken over
+ * the chunk samples. Throughput cases report their aggregate cost per op.
+ * Thread contention sweeps live in emergency_bench_mt.c.
+ *
+ *   emergency_bench          human readable table
+ *   emergency_bench --json   one JSON document on stdout
+ */
+
+#define BENCH_NODES 4096
+#define BENCH_CHUNK 64
+#define BENCH_WARMUP 5
+#define BENCH_REPETITIONS 51
+#define BENCH_SAMPLES (BENCH_REPETITIONS * (BENCH_NODES / BENCH_CHUNK))
+#define BENCH_ITERATIONS 10000000
+
+static EmergencyNode_t nodes[BENCH_NODES];
+static uint64_t samples[BENCH_SAMPLES];
+static volatile int8_t sink;
+
+typedef void (*BenchPrepare)(EmergencyNode_t* node);
+typedef void (*BenchOp)(EmergencyNode_t* node);
+
+// always inlined so the operation is not measured through a function pointer
+static inline __attribute__((__always_inline__))
+void run_case(const char* name, const BenchPrepare prepare, const BenchOp op)
+{
+    uint32_t count = 0;
+
+    for (int rep = 0; rep < BENCH_WARMUP + BENCH_REPETITIONS; rep++) {
+        for (int i = 0; i < BENCH_NODES; i++) {
+            EmergencyNode_destroy(&nodes[i]);
+            prepare(&nodes[i]);
+        }
+
+        for (int chunk = 0; chunk < BENCH_NODES; chunk += BENCH_CHUNK) {
+            const uint64_t start = EmergencyClock_cycles();
+            for (int i = chunk; i < chunk + BENCH_CHUNK; i++) {
+                op(&nodes[i]);
+            }
+            const uint64_t elapsed = EmergencyClock_cycles() - start;
+            if (rep >= BENCH_WARMUP) {
+                samples[count++] = elapsed;
+            }
+        }
+    }
+
+    for (int i = 0; i < BENCH_NODES; i++) {
+        EmergencyNode_destroy(&nodes[i]);
+    }
+
+    qsort(samples, count, sizeof(samples[0]), compare_samples);
+    BenchResult* result = new_result(name, 1, (uint64_t)count * BENCH_CHUNK);
+    result->cycles_median = (double)samples[count / 2] / BENCH_CHUNK;
+    result->cycles_p99 = (double)samples[(count * 99) / 100] / BENCH_CHUNK;
+    result->ns_median = result->cycles_median * ns_per_cycle;
+    result->ns_p99 = result->cycles_p99 * ns_per_cycle;
+    result->mops = 1e3 / result->ns_median;
+}
+
+static void prepare_clear(EmergencyNode_t* node)
+{
+    EmergencyNode_init(node);
+}
+
+static void prepare_raised(EmergencyNode_t* node)
+{
+    EmergencyNode_init(node);
+    EmergencyNode_raise(node, 5);
+}
+
+static void prepare_latched(EmergencyNode_t* node)
+{
+    EmergencyNode_init(node);
+    EmergencyNode_raise(node, 63);
+}
+
+static void prepare_raised_latched(EmergencyNode_t* node)
+{
+    prepare_latched(node);
+    EmergencyNode_raise(node, 5);
+}
+
+static void op_raise(EmergencyNode_t* node)
+{
+    EmergencyNode_raise(node, 5);
+}
+
+static void op_solve(EmergencyNode_t* node)
+{
+    EmergencyNode_solve(node, 5);
+}
+
+static void op_is_emergency_state(EmergencyNode_t* node)
+{
+    sink = EmergencyNode_is_emergency_state(node);
+}
+
+static void op_destroy(EmergencyNode_t* node)
+{
+    EmergencyNode_destroy(node);
+}
+
+#ifdef EMERGENCY_SEVERITY
+static void op_severity_highest(EmergencyNode_t* node)
+{
+    (void)node;
+    sink = EmergencySeverity_highest();
+}
+#endif
+
+static void bench_micro(void)
+{
+    // the node already has another exception, so no global edge is involved
+    run_case("raise (new bit)", prepare_latched, op_raise);
+    run_case("raise (node edge)", prepare_clear, op_raise);
+    // sensor tasks re-raise an active fault at high rate: this must stay a load and a compare
+    run_case("raise (already set)", prepare_raised, op_raise);
+    run_case("solve", prepare_raised_latched, op_solve);
+    run_case("solve (node edge)", prepare_raised, op_solve);
+    run_case("is_emergency_state", prepare_clear, op_is_emergency_state);
+    run_case("destroy", prepare_raised, op_destroy);
+#ifdef EMERGENCY_SEVERITY
+    // the torque limiter's per-cycle query, with exception 5 mapped to derate
+    EmergencySeverity_map(EMERGENCY_SEVERITY_DERATE, UINT64_C(1) << 5);
+    run_case("raise (node edge, classified)", prepare_clear, op_raise);
+    run_case("severity_highest", prepare_raised, op_severity_highest);
+    EmergencySeverity_map(EMERGENCY_SEVERITY_DERATE, 0);
+#endif
+#ifdef EMERGENCY_TIMING
+    // the per-call cost above covers untracked nodes; this is one tracked node's edges
+    EmergencyNode_t timed;
+    EmergencyNode_init(&timed);
+    EmergencyNode_raise(&timed, 0);
+    EmergencyTiming_track(&timed);
+    const uint64_t start = EmergencyClock_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        EmergencyNode_raise(&timed, 5);
+        EmergencyNode_solve(&timed, 5);
+    }
+    record("raise + solve (new bit, timed)", 1, (uint64_t)BENCH_ITERATIONS * 2, EmergencyClock_cycles() - start);
+    EmergencyTiming_untrack(&timed);
+    EmergencyNode_destroy(&timed);
+#endif
+}
+
+// Every node enters and leaves emergency once per round; the global counter reaches n.
+static void bench_node_scaling(void)
+{
+    static const int counts[] = {100, 1000, 10000, 100000};
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        const int n = counts[c];
+        EmergencyNode_t* array = malloc((size_t)n * sizeof(*array));
+        if (!array) {
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            EmergencyNode_init(&array[i]);
+        }
+
+        const int rounds = BENCH_ITERATIONS / n;
+        const uint64_t start = EmergencyClock_cycles();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < n; i++) {
+                EmergencyNode_raise(&array[i], 5);
+            }
+            for (int i = 0; i < n; i++) {
+                EmergencyNode_solve(&array[i], 5);
+            }
+        }
+        const uint64_t elapsed = EmergencyClock_cycles() - start;
+
+        char name[48];
+        snprintf(name, sizeof(name), "node edge, %d nodes", n);
+        record(name, 1, (uint64_t)rounds * (uint64_t)n * 2, elapsed);
+        free(array);
+    }
+}
+
+// One scan over 10000 nodes with 1% in emergency, per kernel this CPU has.
+static void bench_bulk_scan(void)
+{
+    static const struct {
+        EmergencyScanKernel_t kernel;
+        const char* name;
+    } kernels[] = {
+        {EMERGENCY_SCAN_SCALAR, "collect_active, 10000 nodes, scalar"},
+        {EMERGENCY_SCAN_SSE2, "collect_active, 10000 nodes, sse2"},
+        {EMERGENCY_SCAN_AVX2, "collect_active, 10000 nodes, avx2"},
+        {EMERGENCY_SCAN_NEON, "collect_active, 10000 nodes, neon"},
+    };
+    const uint32_t n = 10000;
+    static uint32_t indices[10000];
+    EmergencyNodeArray_t array;
+    if (EmergencyNode_array_create(&array, n, EMERGENCY_LAYOUT_PACKED)) {
+        return;
+    }
+    for (uint32_t i = 0; i < n; i += 100) {
+        EmergencyNode_raise(EmergencyNode_array_at(&array, i), (uint8_t)(i % 64));
+    }
+
+    EmergencyActiveReport_t report = {.indices = indices, .capacity = n};
+    const int rounds = BENCH_ITERATIONS / n;
+    for (unsigned k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (EmergencyScan_select(kernels[k].kernel)) {
+            continue;
+        }
+        const uint64_t start = EmergencyClock_cycles();
+        for (int r = 0; r < rounds; r++) {
+            sink = EmergencyNode_array_collect_active(&array, &report);
+        }
+        const uint64_t elapsed = EmergencyClock_cycles() - start;
+        record(kernels[k].name, 1, (uint64_t)rounds, elapsed);
+    }
+    EmergencyScan_select(EMERGENCY_SCAN_AUTO);
+    EmergencyNode_array_destroy(&array);
+}
+
+// Teardown of 10000 nodes in emergency, one destroy per node against one destroy_range.
+static void bench_range_destroy(void)
+{
+    const uint32_t n = 10000;
+    const int rounds = 100;
+    EmergencyNode_t* array = malloc((size_t)n * sizeof(*array));
+    if (!array) {
+        return;
+    }
+
+    uint64_t single = 0;
+    uint64_t range = 0;
+    for (int r = 0; r < rounds; r++) {
+        EmergencyNode_init_range(array, n);
+        for (uint32_t i = 0; i < n; i++) {
+            EmergencyNode_raise(&array[i], 5);
+        }
+        uint64_t start = EmergencyClock_cycles();
+        for (uint32_t i = 0; i < n; i++) {
+            EmergencyNode_destroy(&array[i]);
+        }
+        single += EmergencyClock_cycles() - start;
+
+        for (uint32_t i = 0; i < n; i++) {
+            EmergencyNode_raise(&array[i], 5);
+        }
+        start = EmergencyClock_cycles();
+        EmergencyNode_destroy_range(array, n);
+        range += EmergencyClock_cycles() - start;
+    }
+
+    record("destroy, 10000 active nodes", 1, (uint64_t)rounds * n, single);
+    record("destroy_range, 10000 active nodes", 1, (uint64_t)rounds * n, range);
+    free(array);
+}
+
+static volatile uint8_t flap_exception = 5;
+
+// A sensor flapping one exception 100 times per control tick, direct and through the debounce stage.
+static void bench_debounce(void)
+{
+    EmergencyDebounceConfig_t config;
+    EmergencyDebounce_t filter;
+    EmergencyNode_t sensor;
+    EmergencyNode_init(&sensor);
+    EmergencyDebounce_config_init(&config, 3, 3);
+    EmergencyDebounce_init(&filter, &sensor, &config);
+
+    uint64_t start = EmergencyClock_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS / 2; i++) {
+        EmergencyNode_raise(&sensor, 5);
+        EmergencyNode_solve(&sensor, 5);
+    }
+    record("flapping raise + solve, direct", 1, BENCH_ITERATIONS, EmergencyClock_cycles() - start);
+
+    start = EmergencyClock_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS / 2; i += 50) {
+        for (int k = 0; k < 50; k++) {
+            // read through a volatile so the inlined flips are not folded away
+            EmergencyDebounce_raise(&filter, flap_exception);
+            EmergencyDebounce_solve(&filter, flap_exception);
+        }
+        EmergencyDebounce_tick(&filter);
+    }
+    record("flapping raise + solve, debounced", 1, BENCH_ITERATIONS, EmergencyClock_cycles() - start);
+    EmergencyNode_destroy(&sensor);
+}
+
+// Acquire and release of one pool handle; the pool never allocates after create.
+static void bench_pool(void)
+{
+    EmergencyNodePool_t pool;
+    if (EmergencyNodePool_create(&pool, BENCH_NODES)) {
+        return;
+    }
+
+    const uint64_t start = EmergencyClock_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink = EmergencyNodePool_release(&pool, EmergencyNodePool_acquire(&pool));
+    }
+    const uint64_t elapsed = EmergencyClock_cycles() - start;
+    record("pool acquire + release", 1, BENCH_ITERATIONS, elapsed);
+    EmergencyNodePool_destroy(&pool);
+}
+
+static void* thread_edge_worker(void* arg)
+{
+    EmergencyNode_t* node = arg;
+    for (int i = 0; i < BENCH_ITERATIONS / 10; i++) {
+        EmergencyNode_raise(node, 5);
+        EmergencyNode_solve(node, 5);
+    }
+    return NULL;
+}
+
+/*
+ * Neighbouring nodes of one array, one per thread. Bit 0 stays raised, so the
+ * global state never changes and only the node lines themselves are written.
+ */
+static void bench_array_layout(const EmergencyNodeLayout_t layout, const char* name)
+{
+    const int threads = 8;
+    pthread_t ids[8];
+    EmergencyNodeArray_t array;
+    if (EmergencyNode_array_create(&array, threads, layout)) {
+        return;
+    }
+
+    for (int t = 0; t < threads; t++) {
+        EmergencyNode_raise(EmergencyNode_array_at(&array, t), 0);
+    }
+    const uint64_t start = EmergencyClock_cycles();
+    for (int t = 0; t < threads; t++) {
+        pthread_create(&ids[t], NULL, thread_edge_worker, EmergencyNode_array_at(&array, t));
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    const uint64_t elapsed = EmergencyClock_cycles() - start;
+
+    record(name, threads, (uint64_t)threads * (BENCH_ITERATIONS / 10) * 2, elapsed);
+    EmergencyNode_array_destroy(&array);
+}
+
+int main(int argc, char** argv)
+{
+    const int json = argc > 1 && !strcmp(argv[1], "--json");
+
+    EmergencyNode_class_init();
+    calibrate();
+
+    bench_micro();
+    bench_node_scaling();
+    bench_bulk_scan();
+    bench_pool();
+    bench_debounce();
+    bench_range_destroy();
+    bench_array_layout(EMERGENCY_LAYOUT_PACKED, "8 threads, packed array");
+    bench_array_layout(EMERGENCY_LAYOUT_PADDED, "8 threads, padded array");
+
+    if (json) {
+        print_json("micro");
+    } else {
+        print_table("Emergency Module benchmark");
+    }
+
+    return 0;
+}
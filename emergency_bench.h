@@ -0,0 +1,111 @@
+#ifndef __EMERGENCY_BENCH__
+#define __EMERGENCY_BENCH__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "emergency_clock.h"
+
+/*
+ * Result table and reporting shared by the benchmark programs. Latency is
+ * per operation; throughput is the aggregate over all threads of a case.
+ */
+
+#define BENCH_MAX_RESULTS 128
+
+typedef struct {
+    char name[48];
+    uint32_t threads;
+    uint64_t ops;
+    double ns_median;
+    double ns_p99;
+    double cycles_median;
+    double cycles_p99;
+    double mops;
+} BenchResult;
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static int result_count = 0;
+static double ns_per_cycle = 1.0;
+
+static inline BenchResult* new_result(const char* name, const uint32_t threads, const uint64_t ops)
+{
+    if (result_count == BENCH_MAX_RESULTS) {
+        fprintf(stderr, "too many benchmark results\n");
+        exit(1);
+    }
+    BenchResult* result = &results[result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->threads = threads;
+    result->ops = ops;
+    return result;
+}
+
+// throughput cases: one aggregate sample
+static inline void record(const char* name, const uint32_t threads, const uint64_t ops, const uint64_t elapsed_cycles)
+{
+    BenchResult* result = new_result(name, threads, ops);
+    result->cycles_median = result->cycles_p99 = (double)elapsed_cycles / (double)ops;
+    result->ns_median = result->ns_p99 = result->cycles_median * ns_per_cycle;
+    result->mops = 1e3 / result->ns_median;
+}
+
+static inline int compare_samples(const void* a, const void* b)
+{
+    const uint64_t x = *(const uint64_t*)a;
+    const uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// samples must be sorted; per_mille in 0..999
+static inline uint64_t percentile(const uint64_t* samples, const uint64_t count, const uint32_t per_mille)
+{
+    return samples[(count * per_mille) / 1000];
+}
+
+static inline void calibrate(void)
+{
+    const uint64_t ns_start = EmergencyClock_now_ns();
+    const uint64_t cycles_start = EmergencyClock_cycles();
+    while (EmergencyClock_now_ns() - ns_start < 50000000u);
+    ns_per_cycle = (double)(EmergencyClock_now_ns() - ns_start) / (double)(EmergencyClock_cycles() - cycles_start);
+}
+
+static inline const char* mode_name(void)
+{
+#if defined(EMERGENCY_GLOBAL_SPINLOCK)
+    return "spinlock";
+#elif defined(EMERGENCY_SHARDED_COUNTER)
+    return "sharded";
+#else
+    return "lock-free";
+#endif
+}
+
+static inline void print_table(const char* title)
+{
+    printf("%s (global counter: %s)\n", title, mode_name());
+    printf("  %-36s %10s %10s %10s %10s %10s\n", "case", "ns/op", "p99 ns", "cyc/op", "p99 cyc", "Mops/s");
+    for (int i = 0; i < result_count; i++) {
+        printf("  %-36s %10.2f %10.2f %10.2f %10.2f %10.2f\n", results[i].name,
+               results[i].ns_median, results[i].ns_p99, results[i].cycles_median, results[i].cycles_p99,
+               results[i].mops);
+    }
+}
+
+static inline void print_json(const char* suite)
+{
+    printf("{\"module\": \"emergency\", \"suite\": \"%s\", \"mode\": \"%s\", \"ns_per_cycle\": %.6f, \"results\": [",
+           suite, mode_name(), ns_per_cycle);
+    for (int i = 0; i < result_count; i++) {
+        printf("%s\n  {\"name\": \"%s\", \"threads\": %u, \"ops\": %llu, \"ns_per_op_median\": %.3f, "
+               "\"ns_per_op_p99\": %.3f, \"cycles_per_op_median\": %.3f, \"cycles_per_op_p99\": %.3f, "
+               "\"mops\": %.3f}",
+               i ? "," : "", results[i].name, results[i].threads, (unsigned long long)results[i].ops,
+               results[i].ns_median, results[i].ns_p99, results[i].cycles_median, results[i].cycles_p99,
+               results[i].mops);
+    }
+    printf("\n]}\n");
+}
+
+#endif // !__EMERGENCY_BENCH__
@@ -0,0 +1,317 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "emergency_bench.h"
+#include "emergency_context.h"
+#include "emergency_module.h"
+#include "emergency_spinlock.h"
+
+/*
+ * Emergency Module contention benchmark.
+ *
+ * Sweeps 1, 2, 4 .. max threads over three setups:
+ *   shared node      every thread raises/solves its own bit of one atomic node
+ *   per-thread node  every thread owns a node on its own cache line, so every
+ *                    raise/solve pair is a global edge
+ *   mixed N% raise   random ids on one shared atomic node, N% raises
+ *   lock             a counter increment under a bare test-and-set loop and
+ *                    under EmergencySpinlock_t, independent of the build mode
+ * Threads start together; throughput is all operations over the wall time of
+ * the slowest thread. Every BENCH_MT_SAMPLE_EVERY-th operation is timed on its
+ * own for the latency percentiles; the median cost of an empty timed region
+ * is subtracted from them.
+ *
+ *   emergency_bench_mt [--json] [--threads N]
+ *
+ * Build with -DEMERGENCY_GLOBAL_SPINLOCK or -DEMERGENCY_SHARDED_COUNTER to
+ * compare the global counter designs.
+ */
+
+#define BENCH_MT_MAX_THREADS 64
+#define BENCH_MT_OPS 200000
+#define BENCH_MT_SAMPLE_EVERY 16
+#define BENCH_MT_SAMPLES (BENCH_MT_OPS / BENCH_MT_SAMPLE_EVERY)
+
+typedef enum {
+    SETUP_SHARED,
+    SETUP_PER_THREAD,
+    SETUP_MIXED,
+    SETUP_LOCK_TAS,
+    SETUP_LOCK_BACKOFF,
+    // per-thread nodes bound to the leaves of an aggregation tree
+    SETUP_TREE,
+} BenchSetup;
+
+#ifdef EMERGENCY_CONTEXTS
+// fan-out 4 below the default context, two levels: 4 subsystems, 16 leaf groups
+#define BENCH_TREE_FAN_OUT 4
+#define BENCH_TREE_GROUPS (BENCH_TREE_FAN_OUT + BENCH_TREE_FAN_OUT * BENCH_TREE_FAN_OUT)
+
+static EmergencyContext_t tree_groups[BENCH_TREE_GROUPS];
+static atomic_ushort tree_leds[BENCH_TREE_GROUPS];
+#endif
+
+typedef struct {
+    EmergencyNode_t node;
+} __attribute__((__aligned__(EMERGENCY_CACHE_LINE))) PaddedNode;
+
+typedef struct {
+    BenchSetup setup;
+    uint32_t index;
+    uint32_t raise_percent;
+    uint64_t rng;
+    uint64_t end;
+} __attribute__((__aligned__(EMERGENCY_CACHE_LINE))) BenchThread;
+
+static EmergencyNodeAtomic_t shared_node __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+static PaddedNode thread_nodes[BENCH_MT_MAX_THREADS];
+static BenchThread thread_args[BENCH_MT_MAX_THREADS];
+static uint64_t samples[BENCH_MT_MAX_THREADS * BENCH_MT_SAMPLES];
+static atomic_flag tas_lock = ATOMIC_FLAG_INIT;
+static EmergencySpinlock_t backoff_lock = EMERGENCY_SPINLOCK_INIT;
+static volatile uint64_t locked_counter;
+static atomic_uint ready;
+static atomic_uint go;
+static uint64_t timer_overhead;
+
+// xorshift64*, one state per thread so no generator state is shared
+static inline uint64_t next_random(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+static inline void run_op(BenchThread* self, const uint32_t i)
+{
+    switch (self->setup) {
+    case SETUP_SHARED:
+        if (i & 1) {
+            EmergencyNodeAtomic_solve(&shared_node, (uint8_t)(self->index % 64));
+        } else {
+            EmergencyNodeAtomic_raise(&shared_node, (uint8_t)(self->index % 64));
+        }
+        break;
+    case SETUP_PER_THREAD:
+    case SETUP_TREE:
+        if (i & 1) {
+            EmergencyNode_solve(&thread_nodes[self->index].node, 5);
+        } else {
+            EmergencyNode_raise(&thread_nodes[self->index].node, 5);
+        }
+        break;
+    case SETUP_MIXED: {
+        const uint64_t r = next_random(&self->rng);
+        const uint8_t exception = (uint8_t)(r % 64);
+        if ((r >> 32) % 100 < self->raise_percent) {
+            EmergencyNodeAtomic_raise(&shared_node, exception);
+        } else {
+            EmergencyNodeAtomic_solve(&shared_node, exception);
+        }
+        break;
+    }
+    case SETUP_LOCK_TAS:
+        while (atomic_flag_test_and_set(&tas_lock));
+        locked_counter++;
+        atomic_flag_clear(&tas_lock);
+        break;
+    case SETUP_LOCK_BACKOFF:
+        EmergencySpinlock_lock(&backoff_lock);
+        locked_counter++;
+        EmergencySpinlock_unlock(&backoff_lock);
+        break;
+    }
+}
+
+static void* bench_worker(void* arg)
+{
+    BenchThread* self = arg;
+    uint64_t* out = &samples[self->index * BENCH_MT_SAMPLES];
+
+    atomic_fetch_add(&ready, 1);
+    while (!atomic_load_explicit(&go, memory_order_acquire)) {
+        sched_yield();
+    }
+
+    for (uint32_t i = 0; i < BENCH_MT_OPS; i++) {
+        if (i % BENCH_MT_SAMPLE_EVERY == 0) {
+            const uint64_t start = EmergencyClock_cycles();
+            run_op(self, i);
+            out[i / BENCH_MT_SAMPLE_EVERY] = EmergencyClock_cycles() - start;
+        } else {
+            run_op(self, i);
+        }
+    }
+    self->end = EmergencyClock_cycles();
+    return NULL;
+}
+
+static void calibrate_timer(void)
+{
+    for (uint32_t i = 0; i < BENCH_MT_SAMPLES; i++) {
+        const uint64_t start = EmergencyClock_cycles();
+        samples[i] = EmergencyClock_cycles() - start;
+    }
+    qsort(samples, BENCH_MT_SAMPLES, sizeof(samples[0]), compare_samples);
+    timer_overhead = percentile(samples, BENCH_MT_SAMPLES, 500);
+}
+
+static double latency_cycles(const uint64_t count, const uint32_t per_mille)
+{
+    const uint64_t cycles = percentile(samples, count, per_mille);
+    return cycles > timer_overhead ? (double)(cycles - timer_overhead) : 0.0;
+}
+
+static void run_sweep_point(const char* label, const BenchSetup setup, const uint32_t raise_percent,
+                            const uint32_t threads)
+{
+    pthread_t ids[BENCH_MT_MAX_THREADS];
+
+    EmergencyNodeAtomic_init(&shared_node);
+    atomic_store(&ready, 0);
+    atomic_store(&go, 0);
+    for (uint32_t t = 0; t < threads; t++) {
+#ifdef EMERGENCY_CONTEXTS
+        if (setup == SETUP_TREE) {
+            const uint32_t leaf = BENCH_TREE_FAN_OUT + t % (BENCH_TREE_GROUPS - BENCH_TREE_FAN_OUT);
+            EmergencyNode_init_in(&thread_nodes[t].node, &tree_groups[leaf]);
+        } else
+#endif
+        EmergencyNode_init(&thread_nodes[t].node);
+        thread_args[t] = (BenchThread){
+            .setup = setup,
+            .index = t,
+            .raise_percent = raise_percent,
+            .rng = 0x9E3779B97F4A7C15ull * (t + 1),
+        };
+        if (pthread_create(&ids[t], NULL, bench_worker, &thread_args[t])) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(1);
+        }
+    }
+    while (atomic_load(&ready) != threads) {
+        sched_yield();
+    }
+
+    const uint64_t start = EmergencyClock_cycles();
+    atomic_store_explicit(&go, 1, memory_order_release);
+    uint64_t end = start;
+    for (uint32_t t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        if (thread_args[t].end > end) {
+            end = thread_args[t].end;
+        }
+        EmergencyNode_destroy(&thread_nodes[t].node);
+    }
+    EmergencyNodeAtomic_destroy(&shared_node);
+
+    const uint64_t count = (uint64_t)threads * BENCH_MT_SAMPLES;
+    qsort(samples, count, sizeof(samples[0]), compare_samples);
+
+    char name[48];
+    snprintf(name, sizeof(name), "%s, %u threads", label, threads);
+    const uint64_t ops = (uint64_t)threads * BENCH_MT_OPS;
+    BenchResult* result = new_result(name, threads, ops);
+    result->cycles_median = latency_cycles(count, 500);
+    result->cycles_p99 = latency_cycles(count, 990);
+    result->ns_median = result->cycles_median * ns_per_cycle;
+    result->ns_p99 = result->cycles_p99 * ns_per_cycle;
+    result->mops = (double)ops / ((double)(end - start) * ns_per_cycle) * 1e3;
+}
+
+static void run_sweep(const char* label, const BenchSetup setup, const uint32_t raise_percent,
+                      const uint32_t max_threads)
+{
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+        run_sweep_point(label, setup, raise_percent, threads);
+    }
+}
+
+#ifdef EMERGENCY_LOCK_PROFILE
+// totals over the whole run, per call site of the global lock
+static void print_lock_profile(void)
+{
+    static const char* const sites[EMERGENCY_LOCK_SITES] = {
+        "_hw_raise_emergency", "_increase_global_emergency_counter",
+        "_solved_module_exception_state", "read_globla_emergency_couner",
+    };
+    EmergencyLockProfile_t profile;
+    if (EmergencyNode_lock_profile(&profile)) {
+        return;
+    }
+
+    printf("\nGlobal lock profile\n");
+    printf("  %-36s %12s %12s %10s %12s %12s\n", "site", "acquired", "failed", "max spin", "hold cyc", "max hold");
+    for (int i = 0; i < EMERGENCY_LOCK_SITES; i++) {
+        const EmergencyLockSiteProfile_t* site = &profile.site[i];
+        printf("  %-36s %12llu %12llu %10u %12.1f %12llu\n", sites[i],
+               (unsigned long long)site->acquisitions, (unsigned long long)site->failed_attempts, site->max_spin,
+               site->acquisitions ? (double)site->hold_cycles / (double)site->acquisitions : 0.0,
+               (unsigned long long)site->max_hold_cycles);
+    }
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    int json = 0;
+    uint32_t max_threads = 32;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            json = 1;
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            max_threads = (uint32_t)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (max_threads < 1 || max_threads > BENCH_MT_MAX_THREADS) {
+        fprintf(stderr, "--threads must be 1..%d\n", BENCH_MT_MAX_THREADS);
+        return 1;
+    }
+
+    EmergencyNode_class_init();
+    calibrate();
+    calibrate_timer();
+
+    run_sweep("shared node", SETUP_SHARED, 0, max_threads);
+    run_sweep("per-thread node", SETUP_PER_THREAD, 0, max_threads);
+#ifdef EMERGENCY_CONTEXTS
+    EmergencyContext_init_tree(tree_groups, tree_leds, BENCH_TREE_GROUPS, BENCH_TREE_FAN_OUT,
+                               EmergencyContext_default());
+    run_sweep("per-thread node, tree", SETUP_TREE, 0, max_threads);
+#endif
+
+    // a latched fault elsewhere keeps the global state up, so no edge reaches the LED
+    EmergencyNode_t latched;
+    EmergencyNode_init(&latched);
+    EmergencyNode_raise(&latched, 0);
+    run_sweep("per-thread node, latched", SETUP_PER_THREAD, 0, max_threads);
+    EmergencyNode_destroy(&latched);
+
+    run_sweep("mixed 10% raise", SETUP_MIXED, 10, max_threads);
+    run_sweep("mixed 50% raise", SETUP_MIXED, 50, max_threads);
+    run_sweep("mixed 90% raise", SETUP_MIXED, 90, max_threads);
+    run_sweep("lock, test-and-set", SETUP_LOCK_TAS, 0, max_threads);
+    run_sweep("lock, TTAS + backoff", SETUP_LOCK_BACKOFF, 0, max_threads);
+
+    if (json) {
+        print_json("contention");
+    } else {
+        print_table("Emergency Module contention benchmark");
+#ifdef EMERGENCY_LOCK_PROFILE
+        print_lock_profile();
+#endif
+    }
+
+    return 0;
+}
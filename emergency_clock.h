@@ -0,0 +1,33 @@
+#ifndef __EMERGENCY_CLOCK__
+#define __EMERGENCY_CLOCK__
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Cheap monotonic time sources shared by the optional instrumentation and the
+ * benchmarks. EmergencyClock_cycles reads the CPU timestamp counter (TSC on
+ * x86, the generic timer on AArch64); it is monotonic but not calibrated.
+ */
+
+static inline uint64_t EmergencyClock_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static inline uint64_t EmergencyClock_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  return EmergencyClock_now_ns();
+#endif
+}
+
+#endif // !__EMERGENCY_CLOCK__
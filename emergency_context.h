@@ -0,0 +1,127 @@
+#ifndef __EMERGENCY_CONTEXT__
+#define __EMERGENCY_CONTEXT__
+
+#include "./emergency_module.h"
+#ifdef EMERGENCY_GLOBAL_SPINLOCK
+#include "./emergency_spinlock.h"
+#endif
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * One emergency domain: the global counter in the layout of the counter mode
+ * the module is built with, the lock guarding it and the LED it drives.
+ *
+ * The module owns a default context, set up by EmergencyNode_class_init and
+ * used by every node initialized without one. With EMERGENCY_CONTEXTS the
+ * application declares further contexts and binds nodes to them
+ * (EmergencyNode_init_in / EmergencyNodeAtomic_init_in); every part of a
+ * context sits on its own cache lines, so domains driven from different cores
+ * share nothing. The members are private to emergency_module.c.
+ *
+ * Contexts also form an aggregation tree: a group context can report to a
+ * parent, where every 0<->1 flip of the group's LED counts as one node edge.
+ * Node edges then only write their group's counter, and only group edges
+ * travel towards the root, so the root sees fan_out times fewer writes per
+ * level. A group's LED (which may be any variable nobody else drives) tells
+ * whether anything below it is in emergency.
+ */
+struct EmergencyContext {
+  atomic_ushort* led;
+  uint8_t init_done;
+#ifdef EMERGENCY_CONTEXTS
+  // tree links, written only while the tree is built
+  EmergencyContext_t* parent;
+  EmergencyContext_t* first_child;
+  EmergencyContext_t* next_sibling;
+#endif
+
+#if defined(EMERGENCY_GLOBAL_SPINLOCK)
+  struct{
+    EmergencySpinlock_t lock;
+    // written only under the lock, read without it by snapshots
+    atomic_int_least32_t excepion_counter;
+  } counter __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+#ifdef EMERGENCY_LOCK_PROFILE
+  // only written by the lock holder
+  struct{
+    EmergencyLockProfile_t profile;
+    EmergencyLockSite_t holder;
+    uint64_t held_since;
+  } lock_profile;
+#endif
+#elif defined(EMERGENCY_SHARDED_COUNTER)
+  struct{
+    atomic_int_least32_t count;
+  } __attribute__((__aligned__(EMERGENCY_CACHE_LINE))) shard[EMERGENCY_COUNTER_SHARDS];
+#else
+  atomic_int_least32_t excepion_counter __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+#endif
+
+#ifdef EMERGENCY_DEFERRED_LED
+  struct{
+    atomic_uint_fast8_t dirty;
+    atomic_flag flushing;
+    // written by the flusher holding flushing, read by every flusher before it
+    _Atomic uint64_t last_write_ns;
+  } led_stage __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+#endif
+} __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+
+#ifdef EMERGENCY_CONTEXTS
+
+/*
+ * Resets the context's counter and binds it to led, which it writes the same
+ * way the default context writes emergency_led. Keep led on a cache line of
+ * its own when the domain runs on a core of its own.
+ */
+int8_t EmergencyContext_init(EmergencyContext_t* const restrict p_self, atomic_ushort* const led)
+  __attribute__((__nonnull__(1, 2)));
+
+uint8_t
+EmergencyContext_global_state(EmergencyContext_t* const restrict p_self)__attribute__((__nonnull__(1)));
+
+int32_t
+EmergencyContext_global_counter(EmergencyContext_t* const restrict p_self)__attribute__((__nonnull__(1)));
+
+// the context of EmergencyNode_class_init, usable as the root of a tree
+EmergencyContext_t* EmergencyContext_default(void);
+
+/*
+ * Like EmergencyContext_init, for a group reporting into parent. Trees are
+ * built before their nodes are used; groups are never unlinked.
+ */
+int8_t EmergencyContext_init_group(EmergencyContext_t* const restrict p_self, atomic_ushort* const led,
+    EmergencyContext_t* const parent)__attribute__((__nonnull__(1, 2, 3)));
+
+/*
+ * Builds count groups with fan_out children per group below root, level by
+ * level: groups[0 .. fan_out-1] report to root, groups[k*fan_out .. k*fan_out + fan_out-1]
+ * to groups[k-1]. Bind leaf nodes to the last groups; leds[i] is the LED of groups[i].
+ */
+int8_t EmergencyContext_init_tree(EmergencyContext_t* const restrict groups, atomic_ushort* const leds,
+    const uint32_t count, const uint32_t fan_out, EmergencyContext_t* const root)__attribute__((__nonnull__(1, 2, 5)));
+
+typedef void (*EmergencyContext_visit_fn)(void* const arg, EmergencyContext_t* const group, const uint8_t depth);
+
+/*
+ * Calls fn for every group below root whose LED is on, depth first; clear
+ * subtrees are skipped without being visited. Returns the number of calls.
+ * With EMERGENCY_DEFERRED_LED the LEDs, and so the walk, follow the flushes:
+ * flush the groups bottom-up.
+ */
+uint32_t EmergencyContext_walk_active(EmergencyContext_t* const restrict root, const EmergencyContext_visit_fn fn,
+    void* const arg)__attribute__((__nonnull__(1, 2)));
+
+#ifdef EMERGENCY_DEFERRED_LED
+int8_t EmergencyContext_led_flush(EmergencyContext_t* const restrict p_self)__attribute__((__nonnull__(1)));
+#endif
+
+#ifdef EMERGENCY_LOCK_PROFILE
+int8_t EmergencyContext_lock_profile(EmergencyContext_t* const restrict p_self,
+    EmergencyLockProfile_t* const restrict p_out)__attribute__((__nonnull__(1, 2)));
+#endif
+
+#endif // EMERGENCY_CONTEXTS
+
+#endif // !__EMERGENCY_CONTEXT__
@@ -0,0 +1,110 @@
+#include "./emergency_debounce.h"
+#include <stdint.h>
+#include <string.h>
+
+//private
+
+_Static_assert(NUM_EMERGENCY_WORDS == 1, "the debounce stage filters one exception word per node");
+
+//public
+
+int8_t EmergencyDebounce_config_init(EmergencyDebounceConfig_t* const restrict p_config, const uint8_t raise_after,
+    const uint8_t solve_after)
+{
+  return EmergencyDebounce_config_set(p_config, UINT64_MAX, raise_after, solve_after);
+}
+
+int8_t EmergencyDebounce_config_set(EmergencyDebounceConfig_t* const restrict p_config, uint64_t mask,
+    const uint8_t raise_after, const uint8_t solve_after)
+{
+  while (mask)
+  {
+    const uint8_t e = (uint8_t) __builtin_ctzll(mask);
+    p_config->raise_after[e] = raise_after;
+    p_config->solve_after[e] = solve_after;
+    mask &= mask - 1;
+  }
+  return 0;
+}
+
+int8_t EmergencyDebounce_init(EmergencyDebounce_t* const restrict p_self, EmergencyNode_t* const node,
+    const EmergencyDebounceConfig_t* const config)
+{
+  memset(p_self, 0, sizeof(*p_self));
+  p_self->node = node;
+  p_self->config = config;
+  p_self->input = node->emergency_buffer[0];
+  return 0;
+}
+
+uint8_t EmergencyDebounce_tick(EmergencyDebounce_t* const restrict p_self)
+{
+  const uint64_t settled = p_self->node->emergency_buffer[0];
+  uint64_t differ = p_self->input ^ settled;
+  // inputs that went back to the node's state before their threshold start over
+  uint64_t restarted = p_self->counting & ~differ;
+  while (restarted)
+  {
+    p_self->ticks[__builtin_ctzll(restarted)] = 0;
+    restarted &= restarted - 1;
+  }
+  if (!differ)
+  {
+    p_self->counting = 0;
+    return 0;
+  }
+
+  uint64_t to_raise = 0;
+  uint64_t to_solve = 0;
+  uint64_t counting = 0;
+  while (differ)
+  {
+    const uint8_t e = (uint8_t) __builtin_ctzll(differ);
+    const uint64_t bit = UINT64_C(1) << e;
+    differ &= differ - 1;
+
+    const uint8_t raising = (p_self->input & bit) != 0;
+    const uint8_t threshold = raising ? p_self->config->raise_after[e] : p_self->config->solve_after[e];
+    if (++p_self->ticks[e] < threshold)
+    {
+      counting |= bit;
+      continue;
+    }
+
+    p_self->ticks[e] = 0;
+    if (raising)
+    {
+      to_raise |= bit;
+    }
+    else
+    {
+      to_solve |= bit;
+    }
+  }
+  p_self->counting = counting;
+
+  if (to_raise)
+  {
+    EmergencyNode_raise_mask(p_self->node, to_raise);
+  }
+  if (to_solve)
+  {
+    EmergencyNode_solve_mask(p_self->node, to_solve);
+  }
+
+  return (uint8_t) __builtin_popcountll(to_raise | to_solve);
+}
+
+uint32_t EmergencyDebounce_tick_all(EmergencyDebounce_t* const restrict filters, const uint32_t count)
+{
+  uint32_t changed = 0;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    // settled filters, the common case, cost one compare
+    if (filters[i].counting || filters[i].input != filters[i].node->emergency_buffer[0])
+    {
+      changed += EmergencyDebounce_tick(&filters[i]);
+    }
+  }
+  return changed;
+}
@@ -0,0 +1,80 @@
+#ifndef __EMERGENCY_DEBOUNCE__
+#define __EMERGENCY_DEBOUNCE__
+
+#include "./emergency_module.h"
+#include <stdint.h>
+
+/*
+ * Debounce stage in front of a plain node, for noisy sensors.
+ *
+ * EmergencyDebounce_raise/solve only record the raw input of an exception in
+ * the filter. EmergencyDebounce_tick, called from the control cycle, compares
+ * the input with the node: an exception whose input stayed raised for
+ * raise_after consecutive ticks is raised on the node, one whose input stayed
+ * solved for solve_after consecutive ticks is solved; an input that flips
+ * back earlier restarts the count. The settled changes of a tick reach the
+ * node as one raise_mask and one solve_mask, so a sensor flapping between
+ * ticks costs the global counter and the LED nothing.
+ *
+ * Thresholds are per exception (ids 0..63) in a config that any number of
+ * filters may share; 0 and 1 both mean "on the next tick". A filter and its
+ * node are driven from one thread, and the debounced exceptions only through
+ * the filter: the tick would undo direct raises and solves.
+ */
+
+typedef struct {
+  uint8_t raise_after[64];
+  uint8_t solve_after[64];
+}EmergencyDebounceConfig_t;
+
+typedef struct {
+  EmergencyNode_t* node;
+  const EmergencyDebounceConfig_t* config;
+  uint64_t input;
+  // exceptions whose input has differed from the node for ticks[e] ticks
+  uint64_t counting;
+  uint8_t ticks[64];
+}EmergencyDebounce_t;
+
+// the same thresholds for every exception
+int8_t EmergencyDebounce_config_init(EmergencyDebounceConfig_t* const restrict p_config, const uint8_t raise_after,
+    const uint8_t solve_after)__attribute__((__nonnull__(1)));
+
+// thresholds for the exceptions in mask
+int8_t EmergencyDebounce_config_set(EmergencyDebounceConfig_t* const restrict p_config, uint64_t mask,
+    const uint8_t raise_after, const uint8_t solve_after)__attribute__((__nonnull__(1)));
+
+// the filter starts with the node's current exceptions as its input
+int8_t EmergencyDebounce_init(EmergencyDebounce_t* const restrict p_self, EmergencyNode_t* const node,
+    const EmergencyDebounceConfig_t* const config)__attribute__((__nonnull__(1, 2, 3)));
+
+static inline int8_t
+EmergencyDebounce_raise(EmergencyDebounce_t* const restrict p_self, const uint8_t exeception)
+{
+  if (exeception >= 64)
+  {
+    return -1;
+  }
+  p_self->input |= UINT64_C(1) << exeception;
+  return 0;
+}
+
+static inline int8_t
+EmergencyDebounce_solve(EmergencyDebounce_t* const restrict p_self, const uint8_t exeception)
+{
+  if (exeception >= 64)
+  {
+    return -1;
+  }
+  p_self->input &= ~(UINT64_C(1) << exeception);
+  return 0;
+}
+
+// settles the filter's node; returns the number of exceptions that changed on it
+uint8_t EmergencyDebounce_tick(EmergencyDebounce_t* const restrict p_self)__attribute__((__nonnull__(1)));
+
+// one tick over count filters; returns the changed exceptions over all nodes
+uint32_t
+EmergencyDebounce_tick_all(EmergencyDebounce_t* const restrict filters, const uint32_t count);
+
+#endif // !__EMERGENCY_DEBOUNCE__
@@ -0,0 +1,152 @@
+#include "./emergency_events.h"
+
+#ifdef EMERGENCY_EVENTS
+
+#include "./emergency_clock.h"
+#include "./emergency_internal.h"
+#include <stdatomic.h>
+
+//private
+
+#if EMERGENCY_EVENTS_CAPACITY & (EMERGENCY_EVENTS_CAPACITY - 1)
+#error "EMERGENCY_EVENTS_CAPACITY must be a power of two"
+#endif
+
+/*
+ * Bounded MPMC queue: the sequence of a slot tells producers and consumers
+ * whose turn it is. sequence == position: free for the producer claiming
+ * that position; sequence == position + 1: holds the event of that position.
+ */
+typedef struct {
+  atomic_uint_fast64_t sequence;
+  EmergencyEvent_t event;
+}EventSlot;
+
+static struct{
+  atomic_uint_fast64_t head __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  atomic_uint_fast64_t tail __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  atomic_uint_fast64_t dropped __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  EventSlot slot[EMERGENCY_EVENTS_CAPACITY] __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+}EVENTS;
+
+static void _events_init(void)
+{
+  static atomic_flag init_lock = ATOMIC_FLAG_INIT;
+  static atomic_uint_fast8_t ready;
+
+  if (atomic_load_explicit(&ready, memory_order_acquire))
+  {
+    return;
+  }
+  while (atomic_flag_test_and_set(&init_lock));
+  if (!atomic_load_explicit(&ready, memory_order_relaxed))
+  {
+    for (uint32_t i = 0; i < EMERGENCY_EVENTS_CAPACITY; i++)
+    {
+      atomic_store_explicit(&EVENTS.slot[i].sequence, i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&ready, 1, memory_order_release);
+  }
+  atomic_flag_clear(&init_lock);
+}
+
+//internal
+
+void EmergencyEvents_record(const void* const p_node, const uint8_t exception, const uint8_t kind,
+    const uint32_t node_counter)
+{
+  _events_init();
+
+  uint_fast64_t position = atomic_load_explicit(&EVENTS.tail, memory_order_relaxed);
+  EventSlot* slot;
+  for (;;)
+  {
+    slot = &EVENTS.slot[position & (EMERGENCY_EVENTS_CAPACITY - 1)];
+    const uint_fast64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    const int64_t lag = (int64_t) (sequence - position);
+    if (!lag)
+    {
+      if (atomic_compare_exchange_weak_explicit(&EVENTS.tail, &position, position + 1,
+          memory_order_relaxed, memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (lag < 0)
+    {
+      // full: the oldest event has not been drained yet
+      atomic_fetch_add_explicit(&EVENTS.dropped, 1, memory_order_relaxed);
+      return;
+    }
+    else
+    {
+      position = atomic_load_explicit(&EVENTS.tail, memory_order_relaxed);
+    }
+  }
+
+  slot->event.timestamp_ns = EmergencyClock_now_ns();
+  slot->event.node = p_node;
+  slot->event.node_counter = node_counter;
+  slot->event.exception = exception;
+  slot->event.kind = kind;
+  atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+}
+
+void EmergencyEvents_record_mask(const void* const p_node, uint64_t bits, const uint8_t kind,
+    const uint32_t node_counter)
+{
+  // one event per changed bit, with the counter the node had after each one
+  uint32_t counter = kind == EMERGENCY_EVENT_RAISE ?
+    node_counter - (uint32_t) __builtin_popcountll(bits) : node_counter + (uint32_t) __builtin_popcountll(bits);
+  while (bits)
+  {
+    counter = kind == EMERGENCY_EVENT_RAISE ? counter + 1 : counter - 1;
+    EmergencyEvents_record(p_node, (uint8_t) __builtin_ctzll(bits), kind, counter);
+    bits &= bits - 1;
+  }
+}
+
+//public
+
+uint32_t EmergencyEvents_drain(EmergencyEvent_t* const restrict out, const uint32_t max)
+{
+  _events_init();
+
+  uint32_t count = 0;
+  uint_fast64_t position = atomic_load_explicit(&EVENTS.head, memory_order_relaxed);
+  while (count < max)
+  {
+    EventSlot* const slot = &EVENTS.slot[position & (EMERGENCY_EVENTS_CAPACITY - 1)];
+    const uint_fast64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    const int64_t lag = (int64_t) (sequence - (position + 1));
+    if (!lag)
+    {
+      if (atomic_compare_exchange_weak_explicit(&EVENTS.head, &position, position + 1,
+          memory_order_relaxed, memory_order_relaxed))
+      {
+        out[count++] = slot->event;
+        // hand the slot to the producer one lap ahead
+        atomic_store_explicit(&slot->sequence, position + EMERGENCY_EVENTS_CAPACITY, memory_order_release);
+        position++;
+      }
+    }
+    else if (lag < 0)
+    {
+      // empty, or the next producer is still writing its event
+      break;
+    }
+    else
+    {
+      position = atomic_load_explicit(&EVENTS.head, memory_order_relaxed);
+    }
+  }
+
+  return count;
+}
+
+uint64_t EmergencyEvents_dropped(void)
+{
+  return atomic_load_explicit(&EVENTS.dropped, memory_order_relaxed);
+}
+
+#endif // EMERGENCY_EVENTS
@@ -0,0 +1,53 @@
+#ifndef __EMERGENCY_EVENTS__
+#define __EMERGENCY_EVENTS__
+
+#include <stdint.h>
+
+/*
+ * Raise/solve history, compiled in with -DEMERGENCY_EVENTS.
+ *
+ * Every real bit change of an EmergencyNode_t or EmergencyNodeAtomic_t
+ * (raise of a clear bit, solve of a raised bit, destroy of a raised node) is
+ * written to a fixed ring of EMERGENCY_EVENTS_CAPACITY slots in static
+ * storage. Any thread may produce; a producer claims a slot with one
+ * compare-exchange and never waits for the consumer: when the ring is full
+ * the event is dropped and counted instead. A background logger empties the
+ * ring with EmergencyEvents_drain.
+ *
+ * Events of the sized nodes (emergency_node_sized.h) are not recorded: their
+ * hooks only report node edges, not exception ids.
+ */
+
+#ifdef EMERGENCY_EVENTS
+
+// must be a power of two
+#ifndef EMERGENCY_EVENTS_CAPACITY
+#define EMERGENCY_EVENTS_CAPACITY 1024
+#endif
+
+typedef enum {
+  EMERGENCY_EVENT_RAISE,
+  EMERGENCY_EVENT_SOLVE,
+  // destroy of a node that still had exceptions; exception is 0xFF
+  EMERGENCY_EVENT_CLEAR,
+}EmergencyEventKind_t;
+
+typedef struct {
+  uint64_t timestamp_ns;
+  const void* node;
+  // exceptions active on the node after the change
+  uint32_t node_counter;
+  uint8_t exception;
+  uint8_t kind;
+}EmergencyEvent_t;
+
+// moves up to max events, oldest first, into out; returns how many
+uint32_t
+EmergencyEvents_drain(EmergencyEvent_t* const restrict out, const uint32_t max)__attribute__((__nonnull__(1)));
+
+// events lost because the ring was full
+uint64_t EmergencyEvents_dropped(void);
+
+#endif // EMERGENCY_EVENTS
+
+#endif // !__EMERGENCY_EVENTS__
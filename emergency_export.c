@@ -0,0 +1,56 @@
+#include "./emergency_export.h"
+
+#ifdef EMERGENCY_EXPORT
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// reader side: needs nothing else from the module, so monitors link only this file
+
+//public
+
+const EmergencyRegistryLayout_t* EmergencyExport_attach(const char* const name)
+{
+  const int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+  {
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) || (size_t) st.st_size < sizeof(EmergencyRegistryLayout_t))
+  {
+    close(fd);
+    return NULL;
+  }
+
+  const EmergencyRegistryLayout_t* const p_layout =
+    mmap(NULL, sizeof(EmergencyRegistryLayout_t), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p_layout == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  // the header fields are only complete once the magic is
+  const uint32_t magic = atomic_load_explicit(&p_layout->magic, memory_order_acquire);
+  if (magic != EMERGENCY_EXPORT_MAGIC || p_layout->version != EMERGENCY_EXPORT_VERSION ||
+      p_layout->capacity != EMERGENCY_REGISTRY_CAPACITY ||
+      p_layout->node_size != sizeof(EmergencyNodeAtomic_t) ||
+      p_layout->layout_size != sizeof(EmergencyRegistryLayout_t))
+  {
+    munmap((void*) p_layout, sizeof(EmergencyRegistryLayout_t));
+    return NULL;
+  }
+
+  return p_layout;
+}
+
+int8_t EmergencyExport_detach(const EmergencyRegistryLayout_t* const p_layout)
+{
+  return munmap((void*) p_layout, sizeof(EmergencyRegistryLayout_t)) ? -1 : 0;
+}
+
+#endif // EMERGENCY_EXPORT
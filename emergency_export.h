@@ -0,0 +1,205 @@
+#ifndef __EMERGENCY_EXPORT__
+#define __EMERGENCY_EXPORT__
+
+#include "./emergency_module.h"
+#include "./emergency_registry.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * Layout of the registry storage. The registry keeps its nodes in one of
+ * these; with EMERGENCY_EXPORT it can be moved into a named POSIX shared
+ * memory segment (EmergencyRegistry_export) that other processes map
+ * read-only (EmergencyExport_attach) and read without any syscall.
+ *
+ * Every change of a registered node -- bits, summary and the global counter
+ * update it causes -- happens between an increment of write_begin and one of
+ * write_end of the window of its group: the nodes sharing its cache line.
+ * Writers only touch their group's window, so nodes driven from different
+ * threads scale as well as unregistered ones. A reader that sees
+ * write_end == write_begin in every window before and after its copy has a
+ * consistent snapshot; writers never wait for readers.
+ * global_counter mirrors the module's counter while the registry is
+ * exported; changes from unregistered nodes are not inside the windows.
+ */
+
+#define EMERGENCY_EXPORT_MAGIC 0x454D5247u
+#define EMERGENCY_EXPORT_VERSION 2
+
+// registry nodes sharing a cache line, and so a write window
+#define EMERGENCY_REGISTRY_GROUP_NODES (EMERGENCY_CACHE_LINE / sizeof(EmergencyNodeAtomic_t))
+#define EMERGENCY_REGISTRY_GROUPS (EMERGENCY_REGISTRY_CAPACITY / EMERGENCY_REGISTRY_GROUP_NODES)
+
+// a reader gives up after this many conflicting attempts
+#ifndef EMERGENCY_EXPORT_MAX_RETRIES
+#define EMERGENCY_EXPORT_MAX_RETRIES 1000
+#endif
+
+typedef struct {
+  atomic_uint_fast64_t write_begin;
+  atomic_uint_fast64_t write_end;
+}__attribute__((__aligned__(EMERGENCY_CACHE_LINE))) EmergencyRegistryWindow_t;
+
+typedef struct {
+  // stored last with release when the segment is ready; load it with acquire
+  atomic_uint_least32_t magic;
+  uint16_t version;
+  uint16_t capacity;
+  uint32_t node_size;
+  uint32_t layout_size;
+  EmergencyRegistryWindow_t window[EMERGENCY_REGISTRY_GROUPS];
+  atomic_int_least32_t global_counter __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  atomic_uint_fast64_t summary_words;
+  atomic_uint_fast64_t summary[EMERGENCY_REGISTRY_WORDS];
+  atomic_uint_fast64_t allocated[EMERGENCY_REGISTRY_WORDS];
+  EmergencyNodeAtomic_t nodes[EMERGENCY_REGISTRY_CAPACITY] __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+}EmergencyRegistryLayout_t;
+
+_Static_assert(EMERGENCY_CACHE_LINE % sizeof(EmergencyNodeAtomic_t) == 0, "registry groups must fill cache lines");
+_Static_assert(EMERGENCY_REGISTRY_CAPACITY % EMERGENCY_REGISTRY_GROUP_NODES == 0, "registry capacity must fill its groups");
+
+typedef struct {
+  // sum of the windows' write_end for a consistent copy, advances with every change; 0 otherwise
+  uint64_t version;
+  int32_t global_counter;
+  uint64_t allocated[EMERGENCY_REGISTRY_WORDS];
+  uint64_t nodes[EMERGENCY_REGISTRY_CAPACITY];
+}EmergencyExportSnapshot_t;
+
+// one copy of the layout without any window check, for EmergencyExport_read_best_effort
+static inline void
+EmergencyExport_copy_unchecked(const EmergencyRegistryLayout_t* const restrict p_layout,
+    EmergencyExportSnapshot_t* const restrict p_out, int32_t (*const global_counter)(void))
+{
+  p_out->global_counter = global_counter ? global_counter() :
+    atomic_load_explicit(&p_layout->global_counter, memory_order_relaxed);
+  for (uint16_t i = 0; i < EMERGENCY_REGISTRY_WORDS; i++)
+  {
+    p_out->allocated[i] = atomic_load_explicit(&p_layout->allocated[i], memory_order_relaxed);
+  }
+  for (uint16_t i = 0; i < EMERGENCY_REGISTRY_CAPACITY; i++)
+  {
+    p_out->nodes[i] = atomic_load_explicit(&p_layout->nodes[i].emergency_buffer, memory_order_relaxed);
+  }
+}
+
+/*
+ * Consistent copy of a registry layout, local or mapped from another
+ * process. global_counter, when not NULL, replaces the layout's mirror as the
+ * source of the counter; it is read inside the same windows and must not
+ * block.
+ *
+ * Returns 0 for a consistent copy. A copy conflicts when any writer opens a
+ * window during it, so under steady writes to even one node every attempt
+ * may conflict: after EMERGENCY_EXPORT_MAX_RETRIES conflicting attempts the
+ * read gives up and returns -1, leaving p_out undefined. Readers never make
+ * writers wait.
+ */
+static inline int8_t
+EmergencyExport_read_using(const EmergencyRegistryLayout_t* const restrict p_layout,
+    EmergencyExportSnapshot_t* const restrict p_out, int32_t (*const global_counter)(void))
+{
+  uint64_t end[EMERGENCY_REGISTRY_GROUPS];
+  for (uint32_t attempt = 0; attempt < EMERGENCY_EXPORT_MAX_RETRIES; attempt++)
+  {
+    uint64_t version = 0;
+    uint16_t g = 0;
+    for (; g < EMERGENCY_REGISTRY_GROUPS; g++)
+    {
+      end[g] = atomic_load_explicit(&p_layout->window[g].write_end, memory_order_acquire);
+      if (atomic_load_explicit(&p_layout->window[g].write_begin, memory_order_relaxed) != end[g])
+      {
+        // a writer is inside this window
+        break;
+      }
+      version += end[g];
+    }
+    if (g < EMERGENCY_REGISTRY_GROUPS)
+    {
+      continue;
+    }
+
+    EmergencyExport_copy_unchecked(p_layout, p_out, global_counter);
+
+    atomic_thread_fence(memory_order_acquire);
+    for (g = 0; g < EMERGENCY_REGISTRY_GROUPS; g++)
+    {
+      if (atomic_load_explicit(&p_layout->window[g].write_begin, memory_order_relaxed) != end[g])
+      {
+        break;
+      }
+    }
+    if (g == EMERGENCY_REGISTRY_GROUPS)
+    {
+      p_out->version = version;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+static inline int8_t
+EmergencyExport_read(const EmergencyRegistryLayout_t* const restrict p_layout,
+    EmergencyExportSnapshot_t* const restrict p_out)
+{
+  return EmergencyExport_read_using(p_layout, p_out, NULL);
+}
+
+/*
+ * For monitors that must show something on every poll: EmergencyExport_read,
+ * but when every attempt conflicted it takes one last unchecked copy and
+ * returns 1. Every node word of that copy is exact on its own, but the global
+ * counter and the nodes may disagree by the edges in flight during the copy,
+ * and version is 0.
+ */
+static inline int8_t
+EmergencyExport_read_best_effort(const EmergencyRegistryLayout_t* const restrict p_layout,
+    EmergencyExportSnapshot_t* const restrict p_out)
+{
+  if (!EmergencyExport_read(p_layout, p_out))
+  {
+    return 0;
+  }
+
+  EmergencyExport_copy_unchecked(p_layout, p_out, NULL);
+  p_out->version = 0;
+  return 1;
+}
+
+/*
+ * Whole-system snapshot in this process: every registered node bitmap plus
+ * the module's global counter, read without its lock in every build. Always
+ * consistent: 0, or -1 when writers kept every attempt conflicting, as
+ * EmergencyExport_read_using; the caller retries later or drops the sample.
+ */
+typedef EmergencyExportSnapshot_t EmergencySystemSnapshot_t;
+
+int8_t
+EmergencySystem_snapshot(EmergencySystemSnapshot_t* const restrict out_buf)
+    __attribute__((__nonnull__(1), __warn_unused_result__));
+
+#ifdef EMERGENCY_EXPORT
+
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+    "shared segments need address-free lock-free atomics");
+
+/*
+ * Moves the registry into the shared memory segment name ("/something").
+ * Only possible while no registry node is acquired, since acquired nodes
+ * would keep pointing at the old storage; -1 otherwise or on any mapping
+ * error. The segment is created with O_EXCL: -1 as well when name already
+ * exists, since another process may still map it; a stale segment left by a
+ * crashed process has to be shm_unlink()ed first. The segment stays mapped
+ * for the life of the process.
+ */
+int8_t EmergencyRegistry_export(const char* const name)__attribute__((__nonnull__(1)));
+
+// maps an exported segment read-only; NULL if it is missing or of another layout
+const EmergencyRegistryLayout_t* EmergencyExport_attach(const char* const name)__attribute__((__nonnull__(1)));
+
+int8_t EmergencyExport_detach(const EmergencyRegistryLayout_t* const p_layout)__attribute__((__nonnull__(1)));
+
+#endif // EMERGENCY_EXPORT
+
+#endif // !__EMERGENCY_EXPORT__
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "emergency_clock.h"
+#include "emergency_module.h"
+#include "emergency_replay.h"
+
+/*
+ * Fuzz target for the node state machine (see emergency_replay.h).
+ *
+ * LLVMFuzzerTestOneInput decodes its input into replay ops and aborts at the
+ * first broken invariant, so it plugs into libFuzzer as is:
+ *
+ *   clang -O2 -g -fsanitize=fuzzer,address -DEMERGENCY_FUZZ_LIBFUZZER ... emergency_fuzz.c
+ *
+ * Without EMERGENCY_FUZZ_LIBFUZZER the file builds a standalone driver that
+ * replays the inputs named on the command line, or else feeds the target
+ * xorshift-generated inputs and reports ops/s. A failing generated input is
+ * written to crash-<seed>-<run> for replay:
+ *
+ *   emergency_fuzz [-seed=N] [-runs=N] [FILE...]
+ */
+
+#define FUZZ_MAX_OPS 4096
+#define FUZZ_INPUT_BYTES (FUZZ_MAX_OPS * EMERGENCY_REPLAY_OP_BYTES)
+#define FUZZ_DEFAULT_RUNS 2000
+
+static const char* const INVARIANT_NAMES[] = {
+    "ok", "bad op", "node bits differ from the model", "unexpected return value",
+    "node counter differs from its bits", "node counter differs from the recording",
+    "global counter differs from the nodes in emergency", "LED differs from the global counter",
+};
+
+static EmergencyReplayOp_t ops[FUZZ_MAX_OPS];
+
+static int8_t run_input(const uint8_t* data, size_t size, EmergencyReplayResult_t* result)
+{
+    static int initialized;
+    if (!initialized) {
+        EmergencyNode_class_init();
+        initialized = 1;
+    }
+
+    const uint32_t count = EmergencyReplay_decode(data, size, ops, FUZZ_MAX_OPS);
+    return EmergencyReplay_run(ops, count, result);
+}
+
+static void report(const EmergencyReplayResult_t* result)
+{
+    const EmergencyReplayOp_t* op = &ops[result->failed_op];
+    fprintf(stderr, "invariant broken at op %u: %s (kind %u node %u exception %u mask 0x%016llx)\n",
+        result->failed_op, INVARIANT_NAMES[result->violated], op->kind, op->node, op->exception,
+        (unsigned long long) op->mask);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    EmergencyReplayResult_t result;
+    if (run_input(data, size, &result)) {
+        report(&result);
+        abort();
+    }
+    return 0;
+}
+
+#ifndef EMERGENCY_FUZZ_LIBFUZZER
+static uint8_t input[FUZZ_INPUT_BYTES];
+
+static uint64_t xorshift64(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static int replay_file(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+    const size_t size = fread(input, 1, sizeof(input), file);
+    fclose(file);
+
+    EmergencyReplayResult_t result;
+    if (run_input(input, size, &result)) {
+        fprintf(stderr, "%s: ", path);
+        report(&result);
+        return 1;
+    }
+    printf("%s: %u ops ok\n", path, result.ops_run);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t seed = 1;
+    uint32_t runs = FUZZ_DEFAULT_RUNS;
+    int files = 0;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "-seed=", 6)) {
+            seed = strtoull(argv[i] + 6, NULL, 0);
+        } else if (!strncmp(argv[i], "-runs=", 6)) {
+            runs = (uint32_t) strtoul(argv[i] + 6, NULL, 0);
+        } else {
+            files++;
+            failed |= replay_file(argv[i]);
+        }
+    }
+    if (files) {
+        return failed;
+    }
+
+    uint64_t state = seed ? seed : 1;
+    uint64_t total_ops = 0;
+    uint64_t elapsed_ns = 0;
+    for (uint32_t run = 0; run < runs; run++) {
+        // lengths vary so short sequences, where most edges happen, are covered too
+        const size_t size = (size_t) (xorshift64(&state) % FUZZ_INPUT_BYTES);
+        for (size_t i = 0; i < size; i += 8) {
+            const uint64_t random = xorshift64(&state);
+            memcpy(&input[i], &random, size - i < 8 ? size - i : 8);
+        }
+
+        EmergencyReplayResult_t result;
+        const uint64_t start = EmergencyClock_now_ns();
+        const int8_t status = run_input(input, size, &result);
+        elapsed_ns += EmergencyClock_now_ns() - start;
+        total_ops += result.ops_run;
+        if (status) {
+            char path[64];
+            snprintf(path, sizeof(path), "crash-%llu-%u", (unsigned long long) seed, run);
+            FILE* file = fopen(path, "wb");
+            if (file) {
+                fwrite(input, 1, size, file);
+                fclose(file);
+            }
+            report(&result);
+            fprintf(stderr, "input written to %s\n", path);
+            return 1;
+        }
+    }
+
+    printf("%u runs, %llu ops, %.1f Mops/s\n", runs, (unsigned long long) total_ops,
+        elapsed_ns ? (double) total_ops * 1e3 / (double) elapsed_ns : 0.0);
+    return 0;
+}
+#endif // !EMERGENCY_FUZZ_LIBFUZZER
@@ -0,0 +1,125 @@
+#ifndef __EMERGENCY_INTERNAL__
+#define __EMERGENCY_INTERNAL__
+
+#include "./emergency_module.h"
+#include "./emergency_events.h"
+
+// Hooks shared between the module's translation units; not part of the API.
+
+// called after every 0<->1 edge of an EmergencyNodeAtomic_t
+void EmergencyRegistry_node_edge(const EmergencyNodeAtomic_t* const p_node);
+
+/*
+ * Bracket every change of an EmergencyNodeAtomic_t (see emergency_export.h);
+ * begin returns the node's registry index, -1 if unregistered, to be passed
+ * to end.
+ */
+int16_t EmergencyRegistry_write_begin(const EmergencyNodeAtomic_t* const p_node);
+void EmergencyRegistry_write_end(const int16_t index);
+
+// EmergencyNode_global_counter without the counter lock of EMERGENCY_GLOBAL_SPINLOCK
+int32_t EmergencyNode_global_counter_unlocked(void);
+
+/*
+ * Change notification points (see emergency_notify.h): the LED flipped to
+ * state, or an EmergencyNodeAtomic_t had a 0<->1 edge. Both are called
+ * outside the counter lock, node edges after the registry write window.
+ */
+void EmergencyNotify_led_changed(const uint8_t state);
+void EmergencyNotify_node_edge(const EmergencyNodeAtomic_t* const p_node, const uint8_t state);
+
+// the exported segment's copy of the global counter, NULL until exported
+#ifdef EMERGENCY_EXPORT
+extern atomic_int_least32_t* _Atomic EmergencyExport_counter_mirror;
+
+/*
+ * Counter change of an edge that found no mirror yet. It is kept aside until
+ * the export moves it into the segment, so an edge racing the export is
+ * counted there exactly once.
+ */
+void EmergencyExport_counter_unpublished(const int32_t delta);
+
+#define EMERGENCY_EXPORT_COUNTER(delta) do { \
+    atomic_int_least32_t* const _mirror = \
+      atomic_load_explicit(&EmergencyExport_counter_mirror, memory_order_relaxed); \
+    if (_mirror) \
+    { \
+      atomic_fetch_add_explicit(_mirror, (delta), memory_order_relaxed); \
+    } \
+    else \
+    { \
+      EmergencyExport_counter_unpublished(delta); \
+    } \
+  } while (0)
+#else
+#define EMERGENCY_EXPORT_COUNTER(delta) ((void) 0)
+#endif
+
+/*
+ * Trace points (see emergency_trace.h). Without EMERGENCY_TRACE they expand to
+ * nothing and their arguments are never evaluated at run time.
+ */
+#ifdef EMERGENCY_TRACE
+void EmergencyTrace_raise_begin(void);
+void EmergencyTrace_led_on(void);
+void EmergencyTrace_raise_end(void);
+void EmergencyTrace_spin(const uint32_t spins);
+
+#define EMERGENCY_TRACE_RAISE_BEGIN() EmergencyTrace_raise_begin()
+#define EMERGENCY_TRACE_LED_ON() EmergencyTrace_led_on()
+#define EMERGENCY_TRACE_RAISE_END() EmergencyTrace_raise_end()
+#define EMERGENCY_TRACE_SPIN(spins) EmergencyTrace_spin(spins)
+#else
+#define EMERGENCY_TRACE_RAISE_BEGIN() ((void) 0)
+#define EMERGENCY_TRACE_LED_ON() ((void) 0)
+#define EMERGENCY_TRACE_RAISE_END() ((void) 0)
+#define EMERGENCY_TRACE_SPIN(spins) ((void) sizeof(spins))
+#endif
+
+/*
+ * Event history points (see emergency_events.h): one exception, or every bit
+ * of a mask, changed on a node that now has counter exceptions.
+ */
+#ifdef EMERGENCY_EVENTS
+void EmergencyEvents_record(const void* const p_node, const uint8_t exception, const uint8_t kind,
+    const uint32_t node_counter);
+void EmergencyEvents_record_mask(const void* const p_node, uint64_t bits, const uint8_t kind,
+    const uint32_t node_counter);
+
+#define EMERGENCY_EVENT(node, exception, kind, counter) EmergencyEvents_record(node, exception, kind, counter)
+#define EMERGENCY_EVENT_MASK(node, bits, kind, counter) EmergencyEvents_record_mask(node, bits, kind, counter)
+#else
+#define EMERGENCY_EVENT(node, exception, kind, counter) ((void) 0)
+#define EMERGENCY_EVENT_MASK(node, bits, kind, counter) ((void) 0)
+#endif
+
+/*
+ * Severity points (see emergency_severity.h): the exceptions in bits (ids
+ * 0..63) were raised (+1) or solved (-1) on some node.
+ */
+#ifdef EMERGENCY_SEVERITY
+void EmergencySeverity_change(const uint64_t bits, const int8_t direction);
+
+#define EMERGENCY_SEVERITY_RAISED(bits) EmergencySeverity_change(bits, 1)
+#define EMERGENCY_SEVERITY_SOLVED(bits) EmergencySeverity_change(bits, -1)
+#else
+#define EMERGENCY_SEVERITY_RAISED(bits) ((void) 0)
+#define EMERGENCY_SEVERITY_SOLVED(bits) ((void) 0)
+#endif
+
+/*
+ * Timing points (see emergency_timing.h): the exceptions in bits (ids 0..63)
+ * had their 0->1 or 1->0 edge on p_node.
+ */
+#ifdef EMERGENCY_TIMING
+void EmergencyTiming_raised(const void* const p_node, const uint64_t bits);
+void EmergencyTiming_solved(const void* const p_node, const uint64_t bits);
+
+#define EMERGENCY_TIMING_RAISED(node, bits) EmergencyTiming_raised(node, bits)
+#define EMERGENCY_TIMING_SOLVED(node, bits) EmergencyTiming_solved(node, bits)
+#else
+#define EMERGENCY_TIMING_RAISED(node, bits) ((void) 0)
+#define EMERGENCY_TIMING_SOLVED(node, bits) ((void) 0)
+#endif
+
+#endif // !__EMERGENCY_INTERNAL__
@@ -1,138 +1,1209 @@
 #include "./emergency_module.h"
+#include "./emergency_internal.h"
+#include "./emergency_context.h"
+#if defined(EMERGENCY_LOCK_PROFILE) || defined(EMERGENCY_DEFERRED_LED)
+#include "./emergency_clock.h"
+#endif
 #include <stdatomic.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 //private
 
 typedef atomic_ushort gpio;
 
-gpio emergency_led;
+// the LED and the counters live on separate cache lines: LED writes must not slow counter updates
+gpio emergency_led __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
 
-static struct{
-  atomic_flag lock;
-  uint8_t excepion_counter;
-  uint8_t init_done:1;
-}EXCEPTION_COUNTER;
+static EmergencyContext_t DEFAULT_CONTEXT = {
+  .led = &emergency_led,
+#ifdef EMERGENCY_DEFERRED_LED
+  .led_stage = {.flushing = ATOMIC_FLAG_INIT},
+#endif
+};
 
-static inline void _hw_raise_emergency(void)
+// without EMERGENCY_CONTEXTS every node counts towards the default context
+#ifdef EMERGENCY_CONTEXTS
+#define NODE_CONTEXT(p_node) ((p_node)->context)
+#else
+#define NODE_CONTEXT(p_node) (&DEFAULT_CONTEXT)
+#endif
+
+// the exported registry only holds nodes of the default context
+#define CONTEXT_EXPORT_COUNTER(ctx, delta) do { \
+    if ((ctx) == &DEFAULT_CONTEXT) \
+    { \
+      EMERGENCY_EXPORT_COUNTER(delta); \
+    } \
+  } while (0)
+
+/*
+ * Every 0<->1 write of a context's LED, after the counter lock is released.
+ * Flips alternate per context, so a group can count them as node edges.
+ */
+static void _led_flipped(EmergencyContext_t* const ctx, const uint8_t state);
+
+#ifdef EMERGENCY_DEFERRED_LED
+/*
+ * Deferred LED: a counter edge only marks the LED dirty, and
+ * EmergencyNode_led_flush does the one GPIO write for every edge since the
+ * last flush. The flusher is then the only writer of the context's LED.
+ */
+static inline void _led_mark_dirty(EmergencyContext_t* const ctx)
+{
+  // already dirty: the pending flush reads the counter after this edge
+  if (!atomic_load(&ctx->led_stage.dirty))
+  {
+    atomic_store(&ctx->led_stage.dirty, 1);
+  }
+}
+#endif
+
+#ifdef EMERGENCY_GLOBAL_SPINLOCK
+
+// Legacy lock-based aggregation, kept as a baseline for the benchmarks.
+
+/*
+ * With EMERGENCY_LOCK_PROFILE the statistics are only written by the lock
+ * holder, so the lock itself protects them and profiling adds no atomics of
+ * its own.
+ */
+static inline void _counter_lock(EmergencyContext_t* const ctx, const EmergencyLockSite_t site)
+{
+  const uint32_t spins = EmergencySpinlock_lock(&ctx->counter.lock);
+  EMERGENCY_TRACE_SPIN(spins);
+#ifdef EMERGENCY_LOCK_PROFILE
+  EmergencyLockSiteProfile_t* const stats = &ctx->lock_profile.profile.site[site];
+  stats->acquisitions++;
+  stats->failed_attempts += spins;
+  if (spins > stats->max_spin)
+  {
+    stats->max_spin = spins;
+  }
+  ctx->lock_profile.holder = site;
+  ctx->lock_profile.held_since = EmergencyClock_cycles();
+#else
+  (void) site;
+#endif
+}
+
+static inline void _counter_unlock(EmergencyContext_t* const ctx)
 {
-  while (atomic_flag_test_and_set(&EXCEPTION_COUNTER.lock));
-  atomic_store(&emergency_led, 1);
-  atomic_flag_clear(&EXCEPTION_COUNTER.lock);
+#ifdef EMERGENCY_LOCK_PROFILE
+  const uint64_t held = EmergencyClock_cycles() - ctx->lock_profile.held_since;
+  EmergencyLockSiteProfile_t* const stats = &ctx->lock_profile.profile.site[ctx->lock_profile.holder];
+  stats->hold_cycles += held;
+  if (held > stats->max_hold_cycles)
+  {
+    stats->max_hold_cycles = held;
+  }
+#endif
+  EmergencySpinlock_unlock(&ctx->counter.lock);
+}
+
+// the counter is only written by the lock holder, so relaxed loads and stores are enough
+static inline int32_t _locked_counter(EmergencyContext_t* const ctx)
+{
+  return atomic_load_explicit(&ctx->counter.excepion_counter, memory_order_relaxed);
 }
 
-static void _increase_global_emergency_counter(void) 
+static inline int32_t _locked_counter_add(EmergencyContext_t* const ctx, const int32_t delta)
 {
-  while (atomic_flag_test_and_set(&EXCEPTION_COUNTER.lock));
-  EXCEPTION_COUNTER.excepion_counter++;
-  atomic_flag_clear(&EXCEPTION_COUNTER.lock);
+  const int32_t value = _locked_counter(ctx) + delta;
+  atomic_store_explicit(&ctx->counter.excepion_counter, value, memory_order_relaxed);
+  return value;
 }
 
-static void _solved_module_exception_state(void)__attribute__((__unused__));
-static void _solved_module_exception_state(void)
+#ifdef EMERGENCY_DEFERRED_LED
+
+// the counter edge already marked the LED dirty
+static inline void _hw_raise_emergency(EmergencyContext_t* const ctx)
 {
-  while (atomic_flag_test_and_set(&EXCEPTION_COUNTER.lock));
-  EXCEPTION_COUNTER.excepion_counter--;
-  if (!EXCEPTION_COUNTER.excepion_counter)
+  (void) ctx;
+}
+
+static void _increase_global_emergency_counter(EmergencyContext_t* const ctx, const void* const p_node) 
+{
+  (void) p_node;
+  _counter_lock(ctx, EMERGENCY_LOCK_SITE_INCREASE);
+  const uint8_t edge = _locked_counter_add(ctx, 1) == 1;
+  CONTEXT_EXPORT_COUNTER(ctx, 1);
+  _counter_unlock(ctx);
+  if (edge)
   {
-    atomic_store(&emergency_led, 0);
+    _led_mark_dirty(ctx);
   }
-  atomic_flag_clear(&EXCEPTION_COUNTER.lock);
 }
 
-static uint8_t read_globla_emergency_couner(void)__attribute__((__unused__));
-static uint8_t read_globla_emergency_couner(void)
+static void _solved_module_exception_states(EmergencyContext_t* const ctx, const void* const p_node,
+    const int32_t count)
 {
-  while (atomic_flag_test_and_set(&EXCEPTION_COUNTER.lock));
-  const uint8_t res= EXCEPTION_COUNTER.excepion_counter;
-  atomic_flag_clear(&EXCEPTION_COUNTER.lock);
+  (void) p_node;
+  _counter_lock(ctx, EMERGENCY_LOCK_SITE_SOLVED);
+  const int32_t old = _locked_counter(ctx);
+  const uint8_t edge = old > 0 && _locked_counter_add(ctx, -count) <= 0;
+  CONTEXT_EXPORT_COUNTER(ctx, -count);
+  _counter_unlock(ctx);
+  if (edge)
+  {
+    _led_mark_dirty(ctx);
+  }
+}
+
+#else
+
+static inline void _hw_raise_emergency(EmergencyContext_t* const ctx)
+{
+  uint8_t flipped = 0;
+  _counter_lock(ctx, EMERGENCY_LOCK_SITE_HW_RAISE);
+  if (_locked_counter(ctx) > 0)
+  {
+    flipped = !atomic_exchange(ctx->led, 1);
+    EMERGENCY_TRACE_LED_ON();
+  }
+  _counter_unlock(ctx);
+  if (flipped)
+  {
+    _led_flipped(ctx, 1);
+  }
+}
+
+static void _increase_global_emergency_counter(EmergencyContext_t* const ctx, const void* const p_node) 
+{
+  (void) p_node;
+  _counter_lock(ctx, EMERGENCY_LOCK_SITE_INCREASE);
+  _locked_counter_add(ctx, 1);
+  CONTEXT_EXPORT_COUNTER(ctx, 1);
+  _counter_unlock(ctx);
+}
+
+static void _solved_module_exception_states(EmergencyContext_t* const ctx, const void* const p_node,
+    const int32_t count)
+{
+  (void) p_node;
+  uint8_t flipped = 0;
+  _counter_lock(ctx, EMERGENCY_LOCK_SITE_SOLVED);
+  const int32_t value = _locked_counter_add(ctx, -count);
+  CONTEXT_EXPORT_COUNTER(ctx, -count);
+  if (value <= 0)
+  {
+    flipped = atomic_exchange(ctx->led, 0);
+  }
+  _counter_unlock(ctx);
+  if (flipped)
+  {
+    _led_flipped(ctx, 0);
+  }
+}
+
+#endif // EMERGENCY_DEFERRED_LED
+
+static int32_t read_globla_emergency_couner(EmergencyContext_t* const ctx)
+{
+  _counter_lock(ctx, EMERGENCY_LOCK_SITE_READ);
+  const int32_t res= _locked_counter(ctx);
+  _counter_unlock(ctx);
 
   return res;
 }
 
+static int32_t _read_counter_unlocked(EmergencyContext_t* const ctx)
+{
+  return _locked_counter(ctx);
+}
+
+static void _counter_reset(EmergencyContext_t* const ctx)
+{
+  atomic_store(&ctx->counter.excepion_counter, 0);
+}
+
+#else
+
+/*
+ * The counter is signed: with EmergencyNodeAtomic_t a solve on one thread can
+ * retire a node edge before the raise that opened it has been counted, which
+ * briefly takes the counter below zero. The LED follows "counter > 0".
+ */
+#ifdef EMERGENCY_SHARDED_COUNTER
+
+/*
+ * One cache line per shard. The shard is picked from the node address, so a
+ * node is always counted in the same shard whichever thread raises or solves
+ * it: shards stay true counts and the total only has to be summed when a shard
+ * changes sign. Nodes driven from different cores land on different lines and
+ * their edges stop bouncing one shared counter line.
+ */
+static inline uint32_t _counter_slot_index(const void* const p_node)
+{
+  const uint64_t hash = (uint64_t) ((uintptr_t) p_node >> 3) * UINT64_C(0x9E3779B97F4A7C15);
+  return (uint32_t) ((hash >> 32) % EMERGENCY_COUNTER_SHARDS);
+}
+
+static inline atomic_int_least32_t* _counter_slot(EmergencyContext_t* const ctx, const void* const p_node)
+{
+  return &ctx->shard[_counter_slot_index(p_node)].count;
+}
+
+static inline int32_t _counter_total(EmergencyContext_t* const ctx)
+{
+  int32_t total = 0;
+  for (uint16_t i = 0; i < EMERGENCY_COUNTER_SHARDS; i++)
+  {
+    total += atomic_load(&ctx->shard[i].count);
+  }
+  return total;
+}
+
+// the LED is on while any shard is positive; stops at the first one found
+static inline uint8_t _counter_positive(EmergencyContext_t* const ctx)
+{
+  for (uint16_t i = 0; i < EMERGENCY_COUNTER_SHARDS; i++)
+  {
+    if (atomic_load(&ctx->shard[i].count) > 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void _counter_reset(EmergencyContext_t* const ctx)
+{
+  for (uint16_t i = 0; i < EMERGENCY_COUNTER_SHARDS; i++)
+  {
+    atomic_store(&ctx->shard[i].count, 0);
+  }
+}
+
+#else
+
+static inline atomic_int_least32_t* _counter_slot(EmergencyContext_t* const ctx, const void* const p_node)
+{
+  (void) p_node;
+  return &ctx->excepion_counter;
+}
+
+static inline int32_t _counter_total(EmergencyContext_t* const ctx)
+{
+  return atomic_load(&ctx->excepion_counter);
+}
+
+static inline uint8_t _counter_positive(EmergencyContext_t* const ctx)
+{
+  return atomic_load(&ctx->excepion_counter) > 0;
+}
+
+static void _counter_reset(EmergencyContext_t* const ctx)
+{
+  atomic_store(&ctx->excepion_counter, 0);
+}
+
+#endif // EMERGENCY_SHARDED_COUNTER
+
+#ifdef EMERGENCY_DEFERRED_LED
+
+// the counter edge already marked the LED dirty
+static inline void _hw_raise_emergency(EmergencyContext_t* const ctx)
+{
+  (void) ctx;
+}
+
+static void _increase_global_emergency_counter(EmergencyContext_t* const ctx, const void* const p_node) 
+{
+  CONTEXT_EXPORT_COUNTER(ctx, 1);
+  if (atomic_fetch_add(_counter_slot(ctx, p_node), 1) <= 0)
+  {
+    _led_mark_dirty(ctx);
+  }
+}
+
+static void _solved_module_exception_states(EmergencyContext_t* const ctx, const void* const p_node,
+    const int32_t count)
+{
+  CONTEXT_EXPORT_COUNTER(ctx, -count);
+  if (atomic_fetch_sub(_counter_slot(ctx, p_node), count) <= count)
+  {
+    _led_mark_dirty(ctx);
+  }
+}
+
+#else
+
+/*
+ * Brings the context's LED in line with its counter.
+ * The edge seen by fetch_add/fetch_sub may already be stale when the LED is
+ * written, so after every write the counter is checked again: the last thread
+ * to touch the LED always leaves it matching the counter.
+ * The compare-exchange skips the store when the LED already has the value.
+ */
+static void _sync_emergency_led(EmergencyContext_t* const ctx)
+{
+  uint8_t positive = _counter_positive(ctx);
+  uint32_t retries = 0;
+  for (;;)
+  {
+    unsigned short expected = !positive;
+    if (atomic_compare_exchange_strong(ctx->led, &expected, positive))
+    {
+      if (positive)
+      {
+        EMERGENCY_TRACE_LED_ON();
+      }
+      _led_flipped(ctx, positive);
+    }
+
+    const uint8_t now = _counter_positive(ctx);
+    if (now == positive)
+    {
+      break;
+    }
+    positive = now;
+    retries++;
+  }
+  EMERGENCY_TRACE_SPIN(retries);
+}
+
+static inline void _hw_raise_emergency(EmergencyContext_t* const ctx)
+{
+  if (!atomic_load_explicit(ctx->led, memory_order_relaxed))
+  {
+    _sync_emergency_led(ctx);
+  }
+}
+
+/*
+ * Only a counter (or shard) crossing between <= 0 and > 0 can change what the
+ * LED shows, so every other change skips the LED entirely. A crossing upwards
+ * with the LED already on has nothing to do either: a sync racing to turn it
+ * off re-reads the counters after its write and will see this one.
+ */
+static void _increase_global_emergency_counter(EmergencyContext_t* const ctx, const void* const p_node) 
+{
+  CONTEXT_EXPORT_COUNTER(ctx, 1);
+  if (atomic_fetch_add(_counter_slot(ctx, p_node), 1) <= 0)
+  {
+    _hw_raise_emergency(ctx);
+  }
+}
+
+static void _solved_module_exception_states(EmergencyContext_t* const ctx, const void* const p_node,
+    const int32_t count)
+{
+  CONTEXT_EXPORT_COUNTER(ctx, -count);
+  if (atomic_fetch_sub(_counter_slot(ctx, p_node), count) <= count)
+  {
+    _sync_emergency_led(ctx);
+  }
+}
+
+#endif // EMERGENCY_DEFERRED_LED
+
+static int32_t read_globla_emergency_couner(EmergencyContext_t* const ctx)
+{
+  return _counter_total(ctx);
+}
+
+static int32_t _read_counter_unlocked(EmergencyContext_t* const ctx)
+{
+  return _counter_total(ctx);
+}
+
+#endif // EMERGENCY_GLOBAL_SPINLOCK
+
+static inline void _solved_module_exception_state(EmergencyContext_t* const ctx, const void* const p_node)
+{
+  _solved_module_exception_states(ctx, p_node, 1);
+}
+
+#ifdef EMERGENCY_SHARDED_COUNTER
+#define COUNTER_SLOTS EMERGENCY_COUNTER_SHARDS
+#else
+#define COUNTER_SLOTS 1
+
+static inline uint32_t _counter_slot_index(const void* const p_node)
+{
+  (void) p_node;
+  return 0;
+}
+#endif
+
+/*
+ * Node edges retired by one bulk destroy, per context and counter slot: every
+ * slot takes one adjustment for all of its nodes instead of one per node.
+ */
+typedef struct {
+  EmergencyContext_t* ctx;
+  const void* node[COUNTER_SLOTS];
+  int32_t count[COUNTER_SLOTS];
+}SolveBatch;
+
+static void _batch_flush(SolveBatch* const restrict batch)
+{
+  for (uint32_t i = 0; i < COUNTER_SLOTS; i++)
+  {
+    if (batch->count[i])
+    {
+      _solved_module_exception_states(batch->ctx, batch->node[i], batch->count[i]);
+      batch->count[i] = 0;
+    }
+  }
+}
+
+static inline void _batch_add(SolveBatch* const restrict batch, EmergencyContext_t* const ctx,
+    const void* const p_node)
+{
+  if (ctx != batch->ctx)
+  {
+    _batch_flush(batch);
+    batch->ctx = ctx;
+  }
+  const uint32_t slot = _counter_slot_index(p_node);
+  batch->node[slot] = p_node;
+  batch->count[slot]++;
+}
+
+static void _led_flipped(EmergencyContext_t* const ctx, const uint8_t state)
+{
+#ifdef EMERGENCY_CONTEXTS
+  // a group turning on or off is one node edge of its parent
+  EmergencyContext_t* const parent = ctx->parent;
+  if (parent)
+  {
+    if (state)
+    {
+      _increase_global_emergency_counter(parent, ctx);
+      _hw_raise_emergency(parent);
+    }
+    else
+    {
+      _solved_module_exception_state(parent, ctx);
+    }
+  }
+#endif
+  if (ctx == &DEFAULT_CONTEXT)
+  {
+    EmergencyNotify_led_changed(state);
+  }
+}
+
+static void _context_reset(EmergencyContext_t* const ctx)
+{
+  atomic_store(ctx->led, 0);
+#ifdef EMERGENCY_DEFERRED_LED
+  atomic_store(&ctx->led_stage.dirty, 0);
+  atomic_store_explicit(&ctx->led_stage.last_write_ns, 0, memory_order_relaxed);
+#endif
+  _counter_reset(ctx);
+}
+
+#ifdef EMERGENCY_DEFERRED_LED
+static int8_t _led_flush(EmergencyContext_t* const ctx)
+{
+  if (!atomic_load(&ctx->led_stage.dirty))
+  {
+    return 0;
+  }
+  const uint64_t now = EmergencyClock_now_ns();
+  if (now - atomic_load_explicit(&ctx->led_stage.last_write_ns, memory_order_relaxed) < EMERGENCY_LED_PERIOD_NS ||
+      atomic_flag_test_and_set(&ctx->led_stage.flushing))
+  {
+    return 0;
+  }
+  // another flusher may have written between the check and the flag
+  if (now - atomic_load_explicit(&ctx->led_stage.last_write_ns, memory_order_relaxed) < EMERGENCY_LED_PERIOD_NS)
+  {
+    atomic_flag_clear(&ctx->led_stage.flushing);
+    return 0;
+  }
+
+  // cleared before the counter is read, so a later edge marks it again
+  atomic_store(&ctx->led_stage.dirty, 0);
+  const uint8_t positive = read_globla_emergency_couner(ctx) > 0;
+  const uint8_t written = atomic_load_explicit(ctx->led, memory_order_relaxed) != positive;
+  if (written)
+  {
+    atomic_store(ctx->led, positive);
+    atomic_store_explicit(&ctx->led_stage.last_write_ns, now, memory_order_relaxed);
+  }
+  atomic_flag_clear(&ctx->led_stage.flushing);
+
+  if (written)
+  {
+    _led_flipped(ctx, positive);
+  }
+  return written;
+}
+#endif
+
+#ifdef EMERGENCY_LOCK_PROFILE
+static int8_t _lock_profile(EmergencyContext_t* const ctx, EmergencyLockProfile_t* const restrict p_out)
+{
+#ifdef EMERGENCY_GLOBAL_SPINLOCK
+  // taken without _counter_lock so reading the profile does not show up in it
+  EmergencySpinlock_lock(&ctx->counter.lock);
+  *p_out = ctx->lock_profile.profile;
+  EmergencySpinlock_unlock(&ctx->counter.lock);
+  return 0;
+#else
+  (void) ctx;
+  memset(p_out, 0, sizeof(*p_out));
+  return -1;
+#endif
+}
+#endif
+
 //public
 
 int8_t EmergencyNode_class_init(void)
 {
-  if (EXCEPTION_COUNTER.init_done)
+  if (DEFAULT_CONTEXT.init_done)
+  {
+    return -1;
+  }
+  _context_reset(&DEFAULT_CONTEXT);
+  DEFAULT_CONTEXT.init_done=1;
+
+  return 0;
+}
+
+#ifdef EMERGENCY_CONTEXTS
+int8_t EmergencyContext_init(EmergencyContext_t* const restrict p_self, atomic_ushort* const led)
+{
+  memset(p_self, 0, sizeof(*p_self));
+  p_self->led = led;
+#ifdef EMERGENCY_DEFERRED_LED
+  atomic_flag_clear(&p_self->led_stage.flushing);
+#endif
+  _context_reset(p_self);
+  p_self->init_done = 1;
+
+  return 0;
+}
+
+int8_t EmergencyContext_init_group(EmergencyContext_t* const restrict p_self, atomic_ushort* const led,
+    EmergencyContext_t* const parent)
+{
+  if (p_self == parent)
   {
     return -1;
   }
-  atomic_store(&emergency_led, 0);
-  EXCEPTION_COUNTER.init_done=1;
-  EXCEPTION_COUNTER.excepion_counter=0;
+
+  EmergencyContext_init(p_self, led);
+  p_self->parent = parent;
+  // appended, so a walk visits children in the order they were added
+  EmergencyContext_t** link = &parent->first_child;
+  while (*link)
+  {
+    link = &(*link)->next_sibling;
+  }
+  *link = p_self;
 
   return 0;
 }
 
+int8_t EmergencyContext_init_tree(EmergencyContext_t* const restrict groups, atomic_ushort* const leds,
+    const uint32_t count, const uint32_t fan_out, EmergencyContext_t* const root)
+{
+  if (!count || fan_out < 2)
+  {
+    return -1;
+  }
+
+  // level by level: the first fan_out groups under root, fan_out more under each of those, ...
+  for (uint32_t i = 0; i < count; i++)
+  {
+    EmergencyContext_t* const parent = i < fan_out ? root : &groups[i / fan_out - 1];
+    EmergencyContext_init_group(&groups[i], &leds[i], parent);
+  }
+
+  return 0;
+}
+
+EmergencyContext_t* EmergencyContext_default(void)
+{
+  return &DEFAULT_CONTEXT;
+}
+
+static uint32_t _walk_active(EmergencyContext_t* const group, const uint8_t depth,
+    const EmergencyContext_visit_fn fn, void* const arg)
+{
+  uint32_t visited = 0;
+  for (EmergencyContext_t* child = group->first_child; child; child = child->next_sibling)
+  {
+    // a clear group has no active group below it
+    if (!atomic_load(child->led))
+    {
+      continue;
+    }
+    fn(arg, child, depth);
+    visited += 1 + _walk_active(child, depth + 1, fn, arg);
+  }
+  return visited;
+}
+
+uint32_t EmergencyContext_walk_active(EmergencyContext_t* const restrict root, const EmergencyContext_visit_fn fn,
+    void* const arg)
+{
+  return _walk_active(root, 0, fn, arg);
+}
+
+uint8_t EmergencyContext_global_state(EmergencyContext_t* const restrict p_self)
+{
+  return read_globla_emergency_couner(p_self) > 0;
+}
+
+int32_t EmergencyContext_global_counter(EmergencyContext_t* const restrict p_self)
+{
+  return read_globla_emergency_couner(p_self);
+}
+
+#ifdef EMERGENCY_DEFERRED_LED
+int8_t EmergencyContext_led_flush(EmergencyContext_t* const restrict p_self)
+{
+  return _led_flush(p_self);
+}
+#endif
+
+#ifdef EMERGENCY_LOCK_PROFILE
+int8_t EmergencyContext_lock_profile(EmergencyContext_t* const restrict p_self,
+    EmergencyLockProfile_t* const restrict p_out)
+{
+  return _lock_profile(p_self, p_out);
+}
+#endif
+#endif // EMERGENCY_CONTEXTS
+
 int8_t EmergencyNode_init(EmergencyNode_t* const restrict p_self)
 {
   memset(p_self, 0, sizeof(*p_self));
+#ifdef EMERGENCY_CONTEXTS
+  p_self->context = &DEFAULT_CONTEXT;
+#endif
   return 0;
 }
 
-int8_t EmergencyNode_raise(EmergencyNode_t* const restrict p_self, const uint8_t exeception)
+#ifdef EMERGENCY_CONTEXTS
+int8_t EmergencyNode_init_in(EmergencyNode_t* const restrict p_self, EmergencyContext_t* const context)
 {
-  const uint8_t exception_byte = exeception/8;
-  const uint8_t exception_bit = exeception % 8;
+  memset(p_self, 0, sizeof(*p_self));
+  p_self->context = context;
+  return 0;
+}
+#endif
+
+static inline uint64_t _node_any_raised(const EmergencyNode_t* const restrict p_self)
+{
+  uint64_t any = 0;
+  for (uint8_t i = 0; i < NUM_EMERGENCY_WORDS; i++)
+  {
+    any |= p_self->emergency_buffer[i];
+  }
+  return any;
+}
 
+int8_t EmergencyNode_raise(EmergencyNode_t* const restrict p_self, const uint8_t exeception)
+{
   if (exeception >= NUM_EMERGENCY_BUFFER*8)
   {
     return -1;
   }
 
-  const uint8_t old_emergency_bit = (p_self->emergency_buffer[exception_byte] >> exception_bit) & 0x01;
-  p_self->emergency_buffer[exception_byte] |= 1 << exception_bit;
+  uint64_t* const exception_word = &p_self->emergency_buffer[exeception / 64];
+  const uint64_t exception_bit = UINT64_C(1) << (exeception % 64);
+  const uint64_t old_word = *exception_word;
+  if (old_word & exception_bit)
+  {
+    // already raised: the global state cannot change, leave shared memory alone
+    return 0;
+  }
 
-  if (!old_emergency_bit)
+  EMERGENCY_TRACE_RAISE_BEGIN();
+  const uint64_t was_raised = _node_any_raised(p_self);
+  *exception_word = old_word | exception_bit;
+  EMERGENCY_EVENT(p_self, exeception, EMERGENCY_EVENT_RAISE, EmergencyNode_counter(p_self));
+  EMERGENCY_SEVERITY_RAISED(exeception < 64 ? exception_bit : 0);
+  EMERGENCY_TIMING_RAISED(p_self, exeception < 64 ? exception_bit : 0);
+
+  if (!was_raised)
   {
-    if(!p_self->emergency_counter) {
-      _increase_global_emergency_counter();
-    }
-    p_self->emergency_counter++;
+    _increase_global_emergency_counter(NODE_CONTEXT(p_self), p_self);
   }
 
-  _hw_raise_emergency();
+  _hw_raise_emergency(NODE_CONTEXT(p_self));
+  EMERGENCY_TRACE_RAISE_END();
 
   return 0;
 }
 
 int8_t EmergencyNode_solve(EmergencyNode_t* const restrict p_self, const uint8_t exeception)
 {
-  const uint8_t exception_byte = exeception/8;
-  const uint8_t exception_bit = exeception % 8;
-
   if (exeception >= NUM_EMERGENCY_BUFFER * 8)
   {
     return -1;
   }
 
-  if (p_self->emergency_buffer[exception_byte] &  (1 << exception_bit))
+  uint64_t* const exception_word = &p_self->emergency_buffer[exeception / 64];
+  const uint64_t exception_bit = UINT64_C(1) << (exeception % 64);
+  const uint64_t old_word = *exception_word;
+  if (old_word & exception_bit)
+  {
+    *exception_word = old_word & ~exception_bit;
+    EMERGENCY_EVENT(p_self, exeception, EMERGENCY_EVENT_SOLVE, EmergencyNode_counter(p_self));
+    EMERGENCY_SEVERITY_SOLVED(exeception < 64 ? exception_bit : 0);
+    EMERGENCY_TIMING_SOLVED(p_self, exeception < 64 ? exception_bit : 0);
+    if (!_node_any_raised(p_self))
+    {
+      _solved_module_exception_state(NODE_CONTEXT(p_self), p_self);
+    }
+  }
+
+  return 0;
+}
+
+int8_t EmergencyNode_raise_mask(EmergencyNode_t* const restrict p_self, const uint64_t mask)
+{
+  if (mask & ~EMERGENCY_MASK_VALID)
+  {
+    return -1;
+  }
+
+  const uint64_t old_word = p_self->emergency_buffer[0];
+  if (!(mask & ~old_word))
+  {
+    return 0;
+  }
+
+  EMERGENCY_TRACE_RAISE_BEGIN();
+  const uint64_t was_raised = _node_any_raised(p_self);
+  p_self->emergency_buffer[0] = old_word | mask;
+  EMERGENCY_EVENT_MASK(p_self, mask & ~old_word, EMERGENCY_EVENT_RAISE, EmergencyNode_counter(p_self));
+  EMERGENCY_SEVERITY_RAISED(mask & ~old_word);
+  EMERGENCY_TIMING_RAISED(p_self, mask & ~old_word);
+
+  if (!was_raised)
+  {
+    _increase_global_emergency_counter(NODE_CONTEXT(p_self), p_self);
+  }
+
+  _hw_raise_emergency(NODE_CONTEXT(p_self));
+  EMERGENCY_TRACE_RAISE_END();
+
+  return 0;
+}
+
+int8_t EmergencyNode_solve_mask(EmergencyNode_t* const restrict p_self, const uint64_t mask)
+{
+  if (mask & ~EMERGENCY_MASK_VALID)
+  {
+    return -1;
+  }
+
+  const uint64_t old_word = p_self->emergency_buffer[0];
+  if (old_word & mask)
   {
-    p_self->emergency_buffer[exception_byte] ^= (1 << exception_bit);
-    p_self->emergency_counter--;
-    if (!p_self->emergency_counter)
+    p_self->emergency_buffer[0] = old_word & ~mask;
+    EMERGENCY_EVENT_MASK(p_self, old_word & mask, EMERGENCY_EVENT_SOLVE, EmergencyNode_counter(p_self));
+    EMERGENCY_SEVERITY_SOLVED(old_word & mask);
+    EMERGENCY_TIMING_SOLVED(p_self, old_word & mask);
+    if (!_node_any_raised(p_self))
     {
-      _solved_module_exception_state();
+      _solved_module_exception_state(NODE_CONTEXT(p_self), p_self);
     }
   }
 
   return 0;
 }
 
+uint32_t EmergencyNode_counter(const EmergencyNode_t* const restrict p_self)
+{
+  uint32_t counter = 0;
+  for (uint8_t i = 0; i < NUM_EMERGENCY_WORDS; i++)
+  {
+    counter += (uint32_t) __builtin_popcountll(p_self->emergency_buffer[i]);
+  }
+  return counter;
+}
+
 int8_t EmergencyNode_is_emergency_state(const EmergencyNode_t* const restrict p_self)
 {
-  return p_self->emergency_counter || read_globla_emergency_couner();
+  return _node_any_raised(p_self) || read_globla_emergency_couner(NODE_CONTEXT(p_self)) > 0;
 }
 
 int8_t EmergencyNode_destroy(EmergencyNode_t* const restrict p_self)
 {
-  if (p_self->emergency_counter)
+  if (_node_any_raised(p_self))
+  {
+    EMERGENCY_EVENT(p_self, 0xFF, EMERGENCY_EVENT_CLEAR, 0);
+    EMERGENCY_SEVERITY_SOLVED(p_self->emergency_buffer[0]);
+    EMERGENCY_TIMING_SOLVED(p_self, p_self->emergency_buffer[0]);
+    _solved_module_exception_state(NODE_CONTEXT(p_self), p_self);
+  }
+
+  memset(p_self->emergency_buffer, 0, sizeof(p_self->emergency_buffer));
+  return 0;
+}
+
+int8_t EmergencyNode_init_range(EmergencyNode_t* const restrict nodes, const uint32_t count)
+{
+  memset(nodes, 0, (size_t) count * sizeof(*nodes));
+#ifdef EMERGENCY_CONTEXTS
+  for (uint32_t i = 0; i < count; i++)
+  {
+    nodes[i].context = &DEFAULT_CONTEXT;
+  }
+#endif
+  return 0;
+}
+
+#ifdef EMERGENCY_CONTEXTS
+int8_t EmergencyNode_init_range_in(EmergencyNode_t* const restrict nodes, const uint32_t count,
+    EmergencyContext_t* const context)
+{
+  memset(nodes, 0, (size_t) count * sizeof(*nodes));
+  for (uint32_t i = 0; i < count; i++)
   {
-    _solved_module_exception_state();
+    nodes[i].context = context;
   }
+  return 0;
+}
+#endif
+
+static void _destroy_strided(uint8_t* const restrict base, const uint32_t count, const uint32_t stride)
+{
+  SolveBatch batch = {0};
+  for (uint32_t i = 0; i < count; i++)
+  {
+    EmergencyNode_t* const node = (EmergencyNode_t*) (base + (size_t) i * stride);
+    if (_node_any_raised(node))
+    {
+      EMERGENCY_EVENT(node, 0xFF, EMERGENCY_EVENT_CLEAR, 0);
+      EMERGENCY_SEVERITY_SOLVED(node->emergency_buffer[0]);
+      EMERGENCY_TIMING_SOLVED(node, node->emergency_buffer[0]);
+      _batch_add(&batch, NODE_CONTEXT(node), node);
+      memset(node->emergency_buffer, 0, sizeof(node->emergency_buffer));
+    }
+  }
+  _batch_flush(&batch);
+}
+
+int8_t EmergencyNode_destroy_range(EmergencyNode_t* const restrict nodes, const uint32_t count)
+{
+  _destroy_strided((uint8_t*) nodes, count, sizeof(*nodes));
+  return 0;
+}
+
+int8_t EmergencyNode_array_create(EmergencyNodeArray_t* const restrict p_self, const uint32_t count,
+    const EmergencyNodeLayout_t layout)
+{
+  const uint32_t stride = layout == EMERGENCY_LAYOUT_PADDED ? EMERGENCY_CACHE_LINE : sizeof(EmergencyNode_t);
+  // round up so aligned_alloc accepts the size
+  const size_t size = ((size_t) count * stride + EMERGENCY_CACHE_LINE - 1) & ~(size_t) (EMERGENCY_CACHE_LINE - 1);
 
   memset(p_self, 0, sizeof(*p_self));
+  if (!count)
+  {
+    return -1;
+  }
+
+#ifdef _WIN32
+  p_self->nodes = _aligned_malloc(size, EMERGENCY_CACHE_LINE);
+#else
+  p_self->nodes = aligned_alloc(EMERGENCY_CACHE_LINE, size);
+#endif
+  if (!p_self->nodes)
+  {
+    return -1;
+  }
+
+  memset(p_self->nodes, 0, size);
+  p_self->count = count;
+  p_self->stride = stride;
+#ifdef EMERGENCY_CONTEXTS
+  for (uint32_t i = 0; i < count; i++)
+  {
+    EmergencyNode_init(EmergencyNode_array_at(p_self, i));
+  }
+#endif
+
+  return 0;
+}
+
+int8_t EmergencyNode_array_destroy(EmergencyNodeArray_t* const restrict p_self)
+{
+  _destroy_strided(p_self->nodes, p_self->count, p_self->stride);
+
+#ifdef _WIN32
+  _aligned_free(p_self->nodes);
+#else
+  free(p_self->nodes);
+#endif
+  memset(p_self, 0, sizeof(*p_self));
+
+  return 0;
+}
+
+void EmergencyNode_report_raise(const void* const p_node, const uint8_t node_was_clear)
+{
+  EMERGENCY_TRACE_RAISE_BEGIN();
+  if (node_was_clear)
+  {
+    _increase_global_emergency_counter(&DEFAULT_CONTEXT, p_node);
+  }
+  _hw_raise_emergency(&DEFAULT_CONTEXT);
+  EMERGENCY_TRACE_RAISE_END();
+}
+
+void EmergencyNode_report_solved(const void* const p_node)
+{
+  _solved_module_exception_state(&DEFAULT_CONTEXT, p_node);
+}
+
+uint8_t EmergencyNode_global_state(void)
+{
+  return read_globla_emergency_couner(&DEFAULT_CONTEXT) > 0;
+}
+
+int32_t EmergencyNode_global_counter(void)
+{
+  return read_globla_emergency_couner(&DEFAULT_CONTEXT);
+}
+
+int32_t EmergencyNode_global_counter_unlocked(void)
+{
+  return _read_counter_unlocked(&DEFAULT_CONTEXT);
+}
+
+#ifdef EMERGENCY_DEFERRED_LED
+int8_t EmergencyNode_led_flush(void)
+{
+  return _led_flush(&DEFAULT_CONTEXT);
+}
+#endif
+
+#ifdef EMERGENCY_LOCK_PROFILE
+int8_t EmergencyNode_lock_profile(EmergencyLockProfile_t* const restrict p_out)
+{
+  return _lock_profile(&DEFAULT_CONTEXT, p_out);
+}
+
+void EmergencyNode_lock_profile_reset(void)
+{
+#ifdef EMERGENCY_GLOBAL_SPINLOCK
+  EmergencySpinlock_lock(&DEFAULT_CONTEXT.counter.lock);
+  memset(&DEFAULT_CONTEXT.lock_profile.profile, 0, sizeof(DEFAULT_CONTEXT.lock_profile.profile));
+  EmergencySpinlock_unlock(&DEFAULT_CONTEXT.counter.lock);
+#endif
+}
+#endif
+
+int8_t EmergencyNodeAtomic_init(EmergencyNodeAtomic_t* const restrict p_self)
+{
+  // registry nodes are re-initialized while snapshot readers may be copying them
+  atomic_store_explicit(&p_self->emergency_buffer, 0, memory_order_relaxed);
+#ifdef EMERGENCY_CONTEXTS
+  p_self->context = &DEFAULT_CONTEXT;
+#endif
+  return 0;
+}
+
+#ifdef EMERGENCY_CONTEXTS
+int8_t EmergencyNodeAtomic_init_in(EmergencyNodeAtomic_t* const restrict p_self, EmergencyContext_t* const context)
+{
+  atomic_store_explicit(&p_self->emergency_buffer, 0, memory_order_relaxed);
+  p_self->context = context;
+  return 0;
+}
+#endif
+
+int8_t EmergencyNodeAtomic_raise(EmergencyNodeAtomic_t* const restrict p_self, const uint8_t exeception)
+{
+  if (exeception >= NUM_EMERGENCY_BUFFER*8)
+  {
+    return -1;
+  }
+
+  const uint_fast64_t exception_bit = UINT64_C(1) << exeception;
+  if (atomic_load_explicit(&p_self->emergency_buffer, memory_order_relaxed) & exception_bit)
+  {
+    return 0;
+  }
+
+  EMERGENCY_TRACE_RAISE_BEGIN();
+  const int16_t registered = EmergencyRegistry_write_begin(p_self);
+  const uint_fast64_t old_buffer = atomic_fetch_or(&p_self->emergency_buffer, exception_bit);
+  if (old_buffer & exception_bit)
+  {
+    // another thread raised it first
+    EmergencyRegistry_write_end(registered);
+    EMERGENCY_TRACE_RAISE_END();
+    return 0;
+  }
+  EMERGENCY_EVENT(p_self, exeception, EMERGENCY_EVENT_RAISE,
+      (uint32_t) __builtin_popcountll(old_buffer | exception_bit));
+  EMERGENCY_SEVERITY_RAISED(exception_bit);
+  EMERGENCY_TIMING_RAISED(p_self, exception_bit);
+
+  if (!old_buffer)
+  {
+    _increase_global_emergency_counter(NODE_CONTEXT(p_self), p_self);
+    EmergencyRegistry_node_edge(p_self);
+  }
+
+  EmergencyRegistry_write_end(registered);
+  _hw_raise_emergency(NODE_CONTEXT(p_self));
+  if (!old_buffer)
+  {
+    EmergencyNotify_node_edge(p_self, 1);
+  }
+  EMERGENCY_TRACE_RAISE_END();
+
+  return 0;
+}
+
+int8_t EmergencyNodeAtomic_solve(EmergencyNodeAtomic_t* const restrict p_self, const uint8_t exeception)
+{
+  if (exeception >= NUM_EMERGENCY_BUFFER*8)
+  {
+    return -1;
+  }
+
+  const uint_fast64_t exception_bit = UINT64_C(1) << exeception;
+  if (!(atomic_load_explicit(&p_self->emergency_buffer, memory_order_relaxed) & exception_bit))
+  {
+    return 0;
+  }
+
+  const int16_t registered = EmergencyRegistry_write_begin(p_self);
+  const uint_fast64_t old_buffer = atomic_fetch_and(&p_self->emergency_buffer, ~exception_bit);
+  if (old_buffer & exception_bit)
+  {
+    EMERGENCY_EVENT(p_self, exeception, EMERGENCY_EVENT_SOLVE,
+        (uint32_t) __builtin_popcountll(old_buffer & ~exception_bit));
+    EMERGENCY_SEVERITY_SOLVED(exception_bit);
+    EMERGENCY_TIMING_SOLVED(p_self, exception_bit);
+  }
+  if (old_buffer == exception_bit)
+  {
+    _solved_module_exception_state(NODE_CONTEXT(p_self), p_self);
+    EmergencyRegistry_node_edge(p_self);
+  }
+  EmergencyRegistry_write_end(registered);
+  if (old_buffer == exception_bit)
+  {
+    EmergencyNotify_node_edge(p_self, 0);
+  }
+
+  return 0;
+}
+
+int8_t EmergencyNodeAtomic_raise_mask(EmergencyNodeAtomic_t* const restrict p_self, const uint64_t mask)
+{
+  if (mask & ~EMERGENCY_MASK_VALID)
+  {
+    return -1;
+  }
+
+  if (!(mask & ~atomic_load_explicit(&p_self->emergency_buffer, memory_order_relaxed)))
+  {
+    return 0;
+  }
+
+  EMERGENCY_TRACE_RAISE_BEGIN();
+  const int16_t registered = EmergencyRegistry_write_begin(p_self);
+  const uint_fast64_t old_buffer = atomic_fetch_or(&p_self->emergency_buffer, mask);
+  if (!(mask & ~old_buffer))
+  {
+    EmergencyRegistry_write_end(registered);
+    EMERGENCY_TRACE_RAISE_END();
+    return 0;
+  }
+  EMERGENCY_EVENT_MASK(p_self, mask & ~old_buffer, EMERGENCY_EVENT_RAISE,
+      (uint32_t) __builtin_popcountll(old_buffer | mask));
+  EMERGENCY_SEVERITY_RAISED(mask & ~old_buffer);
+  EMERGENCY_TIMING_RAISED(p_self, mask & ~old_buffer);
+
+  if (!old_buffer)
+  {
+    _increase_global_emergency_counter(NODE_CONTEXT(p_self), p_self);
+    EmergencyRegistry_node_edge(p_self);
+  }
+
+  EmergencyRegistry_write_end(registered);
+  _hw_raise_emergency(NODE_CONTEXT(p_self));
+  if (!old_buffer)
+  {
+    EmergencyNotify_node_edge(p_self, 1);
+  }
+  EMERGENCY_TRACE_RAISE_END();
+
+  return 0;
+}
+
+int8_t EmergencyNodeAtomic_solve_mask(EmergencyNodeAtomic_t* const restrict p_self, const uint64_t mask)
+{
+  if (mask & ~EMERGENCY_MASK_VALID)
+  {
+    return -1;
+  }
+
+  if (!(mask & atomic_load_explicit(&p_self->emergency_buffer, memory_order_relaxed)))
+  {
+    return 0;
+  }
+
+  const int16_t registered = EmergencyRegistry_write_begin(p_self);
+  const uint_fast64_t old_buffer = atomic_fetch_and(&p_self->emergency_buffer, ~mask);
+  EMERGENCY_EVENT_MASK(p_self, old_buffer & mask, EMERGENCY_EVENT_SOLVE,
+      (uint32_t) __builtin_popcountll(old_buffer & ~mask));
+  EMERGENCY_SEVERITY_SOLVED(old_buffer & mask);
+  EMERGENCY_TIMING_SOLVED(p_self, old_buffer & mask);
+  const uint8_t cleared = (old_buffer & mask) && !(old_buffer & ~mask);
+  if (cleared)
+  {
+    _solved_module_exception_state(NODE_CONTEXT(p_self), p_self);
+    EmergencyRegistry_node_edge(p_self);
+  }
+  EmergencyRegistry_write_end(registered);
+  if (cleared)
+  {
+    EmergencyNotify_node_edge(p_self, 0);
+  }
+
+  return 0;
+}
+
+uint32_t EmergencyNodeAtomic_counter(const EmergencyNodeAtomic_t* const restrict p_self)
+{
+  return (uint32_t) __builtin_popcountll(atomic_load(&p_self->emergency_buffer));
+}
+
+int8_t EmergencyNodeAtomic_is_emergency_state(const EmergencyNodeAtomic_t* const restrict p_self)
+{
+  return atomic_load(&p_self->emergency_buffer) || read_globla_emergency_couner(NODE_CONTEXT(p_self)) > 0;
+}
+
+int8_t EmergencyNodeAtomic_destroy(EmergencyNodeAtomic_t* const restrict p_self)
+{
+  const int16_t registered = EmergencyRegistry_write_begin(p_self);
+  const uint_fast64_t old_buffer = atomic_exchange(&p_self->emergency_buffer, 0);
+  const uint8_t cleared = old_buffer != 0;
+  if (cleared)
+  {
+    EMERGENCY_EVENT(p_self, 0xFF, EMERGENCY_EVENT_CLEAR, 0);
+    EMERGENCY_SEVERITY_SOLVED(old_buffer);
+    EMERGENCY_TIMING_SOLVED(p_self, old_buffer);
+    _solved_module_exception_state(NODE_CONTEXT(p_self), p_self);
+    EmergencyRegistry_node_edge(p_self);
+  }
+  EmergencyRegistry_write_end(registered);
+  if (cleared)
+  {
+    EmergencyNotify_node_edge(p_self, 0);
+  }
+
   return 0;
 }
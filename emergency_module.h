@@ -1,30 +1,235 @@
 #ifndef __EMERGENCY_MODULE__
 #define __EMERGENCY_MODULE__
 
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#define EMERGENCY_CACHE_LINE 64
+
+/*
+ * Build with EMERGENCY_SHARDED_COUNTER to split the global counter over
+ * EMERGENCY_COUNTER_SHARDS cache lines (see emergency_module.c).
+ */
+#ifndef EMERGENCY_COUNTER_SHARDS
+#define EMERGENCY_COUNTER_SHARDS 32
+#endif
+
 #define NUM_EMERGENCY_BUFFER 8
+#define NUM_EMERGENCY_WORDS ((NUM_EMERGENCY_BUFFER + 7) / 8)
+
+// exceptions reachable through the 64-bit *_mask calls
+#define EMERGENCY_MASK_VALID \
+  (NUM_EMERGENCY_BUFFER >= 8 ? UINT64_MAX : ((UINT64_C(1) << (NUM_EMERGENCY_BUFFER * 8)) - 1))
+
+// emergency domain a node counts towards (see emergency_context.h)
+typedef struct EmergencyContext EmergencyContext_t;
 
+/*
+ * The exceptions are kept as native 64-bit words; the number of active
+ * exceptions is the popcount of the words (see EmergencyNode_counter), so a
+ * default node is a single aligned word. EMERGENCY_CONTEXTS adds the context
+ * the node is bound to.
+ */
 typedef struct {
-  uint8_t emergency_buffer[NUM_EMERGENCY_BUFFER];
-  uint32_t emergency_counter;
+  uint64_t emergency_buffer[NUM_EMERGENCY_WORDS] __attribute__((__aligned__(8)));
+#ifdef EMERGENCY_CONTEXTS
+  EmergencyContext_t* context;
+#endif
 }EmergencyNode_t;
 
+/*
+ * Concurrent node: the same 64 exceptions kept in one atomic word.
+ * raise/solve are a single fetch_or/fetch_and and the counter is derived from
+ * the bits, so one node can be shared by many threads without a mutex.
+ */
+typedef struct {
+  atomic_uint_fast64_t emergency_buffer;
+#ifdef EMERGENCY_CONTEXTS
+  EmergencyContext_t* context;
+#endif
+}EmergencyNodeAtomic_t;
+
+/*
+ * Node arrays: PACKED keeps nodes back to back (8 per cache line) for
+ * read-mostly nodes, PADDED gives every node its own cache line so nodes
+ * written from different threads do not invalidate each other.
+ */
+typedef enum {
+  EMERGENCY_LAYOUT_PACKED,
+  EMERGENCY_LAYOUT_PADDED,
+}EmergencyNodeLayout_t;
+
+typedef struct {
+  uint8_t* nodes;
+  uint32_t count;
+  uint32_t stride;
+}EmergencyNodeArray_t;
+
+static inline EmergencyNode_t*
+EmergencyNode_array_at(const EmergencyNodeArray_t* const restrict p_self, const uint32_t index)
+{
+  return (EmergencyNode_t*) (p_self->nodes + (size_t) index * p_self->stride);
+}
+
 int8_t EmergencyNode_class_init(void);
 
 int8_t
 EmergencyNode_init(EmergencyNode_t* const restrict)__attribute__((__nonnull__(1)));
 
+#ifdef EMERGENCY_CONTEXTS
+// init binding the node to context instead of the default one; destroy keeps the binding
+int8_t
+EmergencyNode_init_in(EmergencyNode_t* const restrict, EmergencyContext_t* const context)__attribute__((__nonnull__(1, 2)));
+#endif
+
 int8_t
 EmergencyNode_raise(EmergencyNode_t* const restrict, const uint8_t exeception)__attribute__((__nonnull__(1)));
 
 int8_t
 EmergencyNode_solve(EmergencyNode_t* const restrict, const uint8_t exeception)__attribute__((__nonnull__(1)));
 
+/*
+ * Raise/solve every exception whose bit is set in mask (ids 0..63) at once.
+ * The global counter and emergency_led are touched at most once per call.
+ */
+int8_t
+EmergencyNode_raise_mask(EmergencyNode_t* const restrict, const uint64_t mask)__attribute__((__nonnull__(1)));
+
+int8_t
+EmergencyNode_solve_mask(EmergencyNode_t* const restrict, const uint64_t mask)__attribute__((__nonnull__(1)));
+
+uint32_t
+EmergencyNode_counter(const EmergencyNode_t* const restrict)__attribute__((__nonnull__(1)));
+
 int8_t
 EmergencyNode_is_emergency_state(const EmergencyNode_t* const restrict) __attribute__((__nonnull__(1)));
 
 int8_t
 EmergencyNode_destroy(EmergencyNode_t* const restrict)__attribute__((__nonnull__(1)));
 
+/*
+ * init/destroy for count nodes back to back. init_range clears them in one
+ * pass; destroy_range solves every node in emergency with one adjustment of
+ * the global counter (per counter shard and context) instead of one lock
+ * round-trip per node.
+ */
+int8_t
+EmergencyNode_init_range(EmergencyNode_t* const restrict, const uint32_t count);
+
+#ifdef EMERGENCY_CONTEXTS
+int8_t
+EmergencyNode_init_range_in(EmergencyNode_t* const restrict, const uint32_t count,
+    EmergencyContext_t* const context)__attribute__((__nonnull__(3)));
+#endif
+
+int8_t
+EmergencyNode_destroy_range(EmergencyNode_t* const restrict, const uint32_t count);
+
+// allocates and initializes count nodes; the only call in this module that allocates
+int8_t
+EmergencyNode_array_create(EmergencyNodeArray_t* const restrict, const uint32_t count,
+    const EmergencyNodeLayout_t layout)__attribute__((__nonnull__(1)));
+
+// destroys every node of the array and releases its memory
+int8_t
+EmergencyNode_array_destroy(EmergencyNodeArray_t* const restrict)__attribute__((__nonnull__(1)));
+
+int8_t
+EmergencyNodeAtomic_init(EmergencyNodeAtomic_t* const restrict)__attribute__((__nonnull__(1)));
+
+#ifdef EMERGENCY_CONTEXTS
+int8_t
+EmergencyNodeAtomic_init_in(EmergencyNodeAtomic_t* const restrict, EmergencyContext_t* const context)
+  __attribute__((__nonnull__(1, 2)));
+#endif
+
+int8_t
+EmergencyNodeAtomic_raise(EmergencyNodeAtomic_t* const restrict, const uint8_t exeception)__attribute__((__nonnull__(1)));
+
+int8_t
+EmergencyNodeAtomic_solve(EmergencyNodeAtomic_t* const restrict, const uint8_t exeception)__attribute__((__nonnull__(1)));
+
+int8_t
+EmergencyNodeAtomic_raise_mask(EmergencyNodeAtomic_t* const restrict, const uint64_t mask)__attribute__((__nonnull__(1)));
+
+int8_t
+EmergencyNodeAtomic_solve_mask(EmergencyNodeAtomic_t* const restrict, const uint64_t mask)__attribute__((__nonnull__(1)));
+
+uint32_t
+EmergencyNodeAtomic_counter(const EmergencyNodeAtomic_t* const restrict)__attribute__((__nonnull__(1)));
+
+int8_t
+EmergencyNodeAtomic_is_emergency_state(const EmergencyNodeAtomic_t* const restrict) __attribute__((__nonnull__(1)));
+
+int8_t
+EmergencyNodeAtomic_destroy(EmergencyNodeAtomic_t* const restrict)__attribute__((__nonnull__(1)));
+
+/*
+ * Global aggregation hooks for node types defined outside this file
+ * (see emergency_node_sized.h): report a newly raised exception, flagging
+ * whether the node was clear before it, and a node that became clear.
+ * They and the EmergencyNode_global_* / led_flush / lock_profile calls below
+ * act on the default context.
+ */
+void EmergencyNode_report_raise(const void* const p_node, const uint8_t node_was_clear);
+
+void EmergencyNode_report_solved(const void* const p_node);
+
+uint8_t EmergencyNode_global_state(void);
+
+// number of nodes currently in emergency
+int32_t EmergencyNode_global_counter(void);
+
+/*
+ * Build with EMERGENCY_DEFERRED_LED to take the LED write out of the raise and
+ * solve paths: they only mark the LED dirty, and EmergencyNode_led_flush,
+ * called from a periodic tick or a worker thread, writes the final state.
+ * Consecutive writes are at least EMERGENCY_LED_PERIOD_NS apart, so with a
+ * flush every T ns an edge reaches the LED within T + EMERGENCY_LED_PERIOD_NS.
+ */
+#ifdef EMERGENCY_DEFERRED_LED
+#ifndef EMERGENCY_LED_PERIOD_NS
+#define EMERGENCY_LED_PERIOD_NS 1000000
+#endif
+
+// 1 if the LED was written, 0 if nothing changed or the period has not passed
+int8_t EmergencyNode_led_flush(void);
+#endif
+
+/*
+ * Call sites of the global counter lock (EMERGENCY_GLOBAL_SPINLOCK). A build
+ * with EMERGENCY_LOCK_PROFILE as well counts, per site, how often the lock
+ * was taken, the failed attempts (backoff rounds, see emergency_spinlock.h),
+ * the longest spin and how long the lock was held (EmergencyClock_cycles
+ * ticks).
+ */
+typedef enum {
+  EMERGENCY_LOCK_SITE_HW_RAISE,
+  EMERGENCY_LOCK_SITE_INCREASE,
+  EMERGENCY_LOCK_SITE_SOLVED,
+  EMERGENCY_LOCK_SITE_READ,
+  EMERGENCY_LOCK_SITES,
+}EmergencyLockSite_t;
+
+#ifdef EMERGENCY_LOCK_PROFILE
+typedef struct {
+  uint64_t acquisitions;
+  uint64_t failed_attempts;
+  uint64_t hold_cycles;
+  uint64_t max_hold_cycles;
+  uint32_t max_spin;
+}EmergencyLockSiteProfile_t;
+
+typedef struct {
+  EmergencyLockSiteProfile_t site[EMERGENCY_LOCK_SITES];
+}EmergencyLockProfile_t;
+
+// consistent copy of every site; -1 in builds without the spinlock
+int8_t
+EmergencyNode_lock_profile(EmergencyLockProfile_t* const restrict)__attribute__((__nonnull__(1)));
+
+void EmergencyNode_lock_profile_reset(void);
+#endif
+
 #endif // !__EMERGENCY_MODULE__
@@ -0,0 +1,232 @@
+#ifndef __EMERGENCY_MODULE_HPP__
+#define __EMERGENCY_MODULE_HPP__
+
+/*
+ * Header-only C++17 layer over emergency_module.h.
+ *
+ *   using OverTemp = emergency::Exception<3>;
+ *   using UnderVoltage = emergency::Exception<7>;
+ *
+ *   emergency::EmergencyNode<16> motor;
+ *   motor.raise<OverTemp>();                  // ids are checked by the compiler
+ *   motor.raise(OverTemp{}, UnderVoltage{});  // one raise_mask for the batch
+ *   {
+ *     auto guard = motor.scoped<UnderVoltage>();  // solved when guard leaves scope
+ *   }
+ *
+ * Exception ids are types, so an id outside the node (or outside the module's
+ * 64 exceptions) is a compile error and the C call only ever sees constant
+ * masks. Re-raising a raised exception and solving a clear one are decided
+ * inline, without a call. Nothing here throws, allocates or needs the C++
+ * library beyond <atomic> and <type_traits> (which C++ has in freestanding
+ * builds too), so it builds with -ffreestanding -fno-exceptions -fno-rtti.
+ */
+
+#if __cplusplus < 201703L
+#error "emergency_module.hpp needs C++17"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// C++ before C++23 has no <stdatomic.h> types; std::atomic of the same lock-free integer has their layout
+#if __cplusplus <= 202002L
+#include <atomic>
+using atomic_uint_fast64_t = std::atomic<uint_fast64_t>;
+#else
+// included here, outside the extern "C" block below
+#include <stdatomic.h>
+#endif
+
+// the C header uses C99 restrict in its inline functions; a restrict of the includer survives
+#pragma push_macro("restrict")
+#undef restrict
+#define restrict __restrict
+extern "C" {
+#include "./emergency_module.h"
+}
+#pragma pop_macro("restrict")
+
+namespace emergency {
+
+static_assert(sizeof(atomic_uint_fast64_t) == sizeof(uint64_t), "atomic node word must match the C layout");
+
+// number of exception ids of a node
+inline constexpr uint16_t capacity = NUM_EMERGENCY_BUFFER * 8;
+
+template <uint8_t Id>
+struct Exception {
+  static_assert(Id < capacity, "exception id outside the module");
+  static_assert(Id < 64, "exception id outside the 64-bit masks of the C API");
+  static constexpr uint8_t id = Id;
+  static constexpr uint64_t mask = UINT64_C(1) << Id;
+};
+
+/*
+ * Holds exceptions of one node raised for its lifetime. Move-only; a moved
+ * from guard solves nothing. Bits are not counted: two guards of the same
+ * exception on one node solve it when the first of them ends.
+ */
+class ScopedEmergency {
+public:
+  ScopedEmergency(EmergencyNode_t* const node, const uint64_t mask) noexcept : node_(node), mask_(mask)
+  {
+    EmergencyNode_raise_mask(node_, mask_);
+  }
+
+  ScopedEmergency(ScopedEmergency&& other) noexcept : node_(other.node_), mask_(other.mask_)
+  {
+    other.node_ = nullptr;
+  }
+
+  ScopedEmergency& operator=(ScopedEmergency&& other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      node_ = other.node_;
+      mask_ = other.mask_;
+      other.node_ = nullptr;
+    }
+    return *this;
+  }
+
+  ScopedEmergency(const ScopedEmergency&) = delete;
+  ScopedEmergency& operator=(const ScopedEmergency&) = delete;
+
+  ~ScopedEmergency()
+  {
+    reset();
+  }
+
+  // solves early; the guard then holds nothing
+  void reset() noexcept
+  {
+    if (node_)
+    {
+      EmergencyNode_solve_mask(node_, mask_);
+      node_ = nullptr;
+    }
+  }
+
+private:
+  EmergencyNode_t* node_;
+  uint64_t mask_;
+};
+
+/*
+ * A plain node limited to ids below N. Nodes are neither copied nor moved:
+ * the module may count a node by its address. The members taking exceptions
+ * drop out of overload resolution for ids outside the node, so the misuse is
+ * a compile error that can also be detected through SFINAE.
+ */
+template <uint16_t N = capacity>
+class EmergencyNode {
+  static_assert(N >= 1 && N <= capacity, "node capacity outside the module");
+
+  template <class... E>
+  static constexpr bool fits = sizeof...(E) > 0 && ((E::id < N) && ...);
+
+  template <class... E>
+  using if_fits = std::enable_if_t<fits<E...>, int>;
+
+  template <class... E>
+  static constexpr uint64_t mask_of() noexcept
+  {
+    static_assert(sizeof...(E) > 0, "name at least one exception");
+    static_assert(((E::id < N) && ...), "exception id outside this node");
+    return (E::mask | ...);
+  }
+
+public:
+  EmergencyNode() noexcept
+  {
+    EmergencyNode_init(&node_);
+  }
+
+  ~EmergencyNode()
+  {
+    EmergencyNode_destroy(&node_);
+  }
+
+  EmergencyNode(const EmergencyNode&) = delete;
+  EmergencyNode& operator=(const EmergencyNode&) = delete;
+
+  template <class... E, if_fits<E...> = 0>
+  void raise() noexcept
+  {
+    constexpr uint64_t mask = mask_of<E...>();
+    if ((node_.emergency_buffer[0] & mask) != mask)
+    {
+      EmergencyNode_raise_mask(&node_, mask);
+    }
+  }
+
+  template <class... E, if_fits<E...> = 0>
+  void solve() noexcept
+  {
+    constexpr uint64_t mask = mask_of<E...>();
+    if (node_.emergency_buffer[0] & mask)
+    {
+      EmergencyNode_solve_mask(&node_, mask);
+    }
+  }
+
+  template <class... E, if_fits<E...> = 0>
+  void raise(E...) noexcept
+  {
+    raise<E...>();
+  }
+
+  template <class... E, if_fits<E...> = 0>
+  void solve(E...) noexcept
+  {
+    solve<E...>();
+  }
+
+  template <class E, if_fits<E> = 0>
+  bool is_raised() const noexcept
+  {
+    return (node_.emergency_buffer[0] & mask_of<E>()) != 0;
+  }
+
+  uint32_t counter() const noexcept
+  {
+    return EmergencyNode_counter(&node_);
+  }
+
+  bool is_emergency_state() const noexcept
+  {
+    return EmergencyNode_is_emergency_state(&node_) != 0;
+  }
+
+  // raises the exceptions now and solves them when the guard is destroyed
+  template <class... E, if_fits<E...> = 0>
+  ScopedEmergency scoped() noexcept
+  {
+    return ScopedEmergency(&node_, mask_of<E...>());
+  }
+
+  EmergencyNode_t* c_node() noexcept
+  {
+    return &node_;
+  }
+
+private:
+  EmergencyNode_t node_;
+};
+
+inline bool global_state() noexcept
+{
+  return EmergencyNode_global_state() != 0;
+}
+
+inline int32_t global_counter() noexcept
+{
+  return EmergencyNode_global_counter();
+}
+
+} // namespace emergency
+
+#endif // !__EMERGENCY_MODULE_HPP__
@@ -0,0 +1,116 @@
+#ifndef __EMERGENCY_NODE_SIZED__
+#define __EMERGENCY_NODE_SIZED__
+
+#include "./emergency_module.h"
+#include <string.h>
+
+/*
+ * Node types with a capacity chosen at compile time.
+ *
+ *   EMERGENCY_NODE_DEFINE(SmallNode, 4, uint8_t)     -> SmallNode_t is 1 byte
+ *   EMERGENCY_NODE_DEFINE(LargeNode, 300, uint64_t)  -> ids 0..299
+ *
+ * defines NAME_t plus NAME_init/raise/solve/counter/is_emergency_state/destroy
+ * with the same contract as the EmergencyNode_* calls. Everything is static
+ * inline over constant sizes, so with a constant id the bounds check and the
+ * word/bit split fold away. Only the node 0<->1 edges reach the module.
+ */
+
+#define EMERGENCY_NODE_WORD_BITS(WORD) (sizeof(WORD) * 8)
+#define EMERGENCY_NODE_WORDS(BITS, WORD) \
+  (((BITS) + EMERGENCY_NODE_WORD_BITS(WORD) - 1) / EMERGENCY_NODE_WORD_BITS(WORD))
+
+#define EMERGENCY_NODE_DEFINE(NAME, BITS, WORD)                                            \
+  typedef struct {                                                                         \
+    WORD emergency_buffer[EMERGENCY_NODE_WORDS(BITS, WORD)];                               \
+  }NAME##_t;                                                                               \
+                                                                                           \
+  static inline WORD NAME##_any_raised(const NAME##_t* const restrict p_self)              \
+  {                                                                                        \
+    WORD any = 0;                                                                          \
+    for (uint32_t i = 0; i < EMERGENCY_NODE_WORDS(BITS, WORD); i++)                        \
+    {                                                                                      \
+      any |= p_self->emergency_buffer[i];                                                  \
+    }                                                                                      \
+    return any;                                                                            \
+  }                                                                                        \
+                                                                                           \
+  static inline int8_t NAME##_init(NAME##_t* const restrict p_self)                        \
+  {                                                                                        \
+    memset(p_self, 0, sizeof(*p_self));                                                    \
+    return 0;                                                                              \
+  }                                                                                        \
+                                                                                           \
+  static inline int8_t NAME##_raise(NAME##_t* const restrict p_self, const uint16_t exeception) \
+  {                                                                                        \
+    if (exeception >= (BITS))                                                              \
+    {                                                                                      \
+      return -1;                                                                           \
+    }                                                                                      \
+                                                                                           \
+    WORD* const exception_word =                                                           \
+      &p_self->emergency_buffer[exeception / EMERGENCY_NODE_WORD_BITS(WORD)];              \
+    const WORD exception_bit = (WORD)((WORD)1 << (exeception % EMERGENCY_NODE_WORD_BITS(WORD))); \
+    const WORD old_word = *exception_word;                                                 \
+    if (old_word & exception_bit)                                                          \
+    {                                                                                      \
+      return 0;                                                                            \
+    }                                                                                      \
+                                                                                           \
+    const WORD was_raised = NAME##_any_raised(p_self);                                     \
+    *exception_word = (WORD)(old_word | exception_bit);                                    \
+    EmergencyNode_report_raise(p_self, !was_raised);                                       \
+                                                                                           \
+    return 0;                                                                              \
+  }                                                                                        \
+                                                                                           \
+  static inline int8_t NAME##_solve(NAME##_t* const restrict p_self, const uint16_t exeception) \
+  {                                                                                        \
+    if (exeception >= (BITS))                                                              \
+    {                                                                                      \
+      return -1;                                                                           \
+    }                                                                                      \
+                                                                                           \
+    WORD* const exception_word =                                                           \
+      &p_self->emergency_buffer[exeception / EMERGENCY_NODE_WORD_BITS(WORD)];              \
+    const WORD exception_bit = (WORD)((WORD)1 << (exeception % EMERGENCY_NODE_WORD_BITS(WORD))); \
+    const WORD old_word = *exception_word;                                                 \
+    if (old_word & exception_bit)                                                          \
+    {                                                                                      \
+      *exception_word = (WORD)(old_word & ~exception_bit);                                 \
+      if (!NAME##_any_raised(p_self))                                                      \
+      {                                                                                    \
+        EmergencyNode_report_solved(p_self);                                               \
+      }                                                                                    \
+    }                                                                                      \
+                                                                                           \
+    return 0;                                                                              \
+  }                                                                                        \
+                                                                                           \
+  static inline uint32_t NAME##_counter(const NAME##_t* const restrict p_self)             \
+  {                                                                                        \
+    uint32_t counter = 0;                                                                  \
+    for (uint32_t i = 0; i < EMERGENCY_NODE_WORDS(BITS, WORD); i++)                        \
+    {                                                                                      \
+      counter += (uint32_t) __builtin_popcountll(p_self->emergency_buffer[i]);             \
+    }                                                                                      \
+    return counter;                                                                        \
+  }                                                                                        \
+                                                                                           \
+  static inline int8_t NAME##_is_emergency_state(const NAME##_t* const restrict p_self)    \
+  {                                                                                        \
+    return NAME##_any_raised(p_self) || EmergencyNode_global_state();                      \
+  }                                                                                        \
+                                                                                           \
+  static inline int8_t NAME##_destroy(NAME##_t* const restrict p_self)                     \
+  {                                                                                        \
+    if (NAME##_any_raised(p_self))                                                         \
+    {                                                                                      \
+      EmergencyNode_report_solved(p_self);                                                 \
+    }                                                                                      \
+                                                                                           \
+    memset(p_self, 0, sizeof(*p_self));                                                    \
+    return 0;                                                                              \
+  }
+
+#endif // !__EMERGENCY_NODE_SIZED__
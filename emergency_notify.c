@@ -0,0 +1,248 @@
+#include "./emergency_notify.h"
+#include "./emergency_internal.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <pthread.h>
+#endif
+
+//private
+
+/*
+ * A slot is claimed by moving state FREE -> CLAIMED, filled, then published
+ * as ACTIVE; notifiers only read ACTIVE slots. Unsubscribe waits for
+ * notifiers still running the slot's callback before it returns.
+ */
+enum {
+  SLOT_FREE,
+  SLOT_CLAIMED,
+  SLOT_ACTIVE,
+};
+
+typedef struct {
+  atomic_uint state;
+  atomic_uint running;
+  const EmergencyNodeAtomic_t* node;
+  EmergencyNotify_fn fn;
+  void* ctx;
+}NotifySlot;
+
+static struct{
+  NotifySlot slot[EMERGENCY_NOTIFY_SUBSCRIBERS];
+  // active slots on the LED / on nodes, so the flip paths stop at one load
+  atomic_uint led_subscribers;
+  atomic_uint node_subscribers;
+  atomic_uint waiters;
+  atomic_uint epoch __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+#ifndef __linux__
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+}NOTIFY
+#ifndef __linux__
+= {.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER}
+#endif
+;
+
+static void _wake(void)
+{
+  atomic_fetch_add(&NOTIFY.epoch, 1);
+  if (!atomic_load(&NOTIFY.waiters))
+  {
+    return;
+  }
+#ifdef __linux__
+  syscall(SYS_futex, &NOTIFY.epoch, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#else
+  pthread_mutex_lock(&NOTIFY.mutex);
+  pthread_cond_broadcast(&NOTIFY.cond);
+  pthread_mutex_unlock(&NOTIFY.mutex);
+#endif
+}
+
+static void _dispatch(const void* const p_node, const uint8_t state)
+{
+  uint8_t matched = 0;
+  for (uint8_t i = 0; i < EMERGENCY_NOTIFY_SUBSCRIBERS; i++)
+  {
+    NotifySlot* const slot = &NOTIFY.slot[i];
+    if (atomic_load(&slot->state) != SLOT_ACTIVE)
+    {
+      continue;
+    }
+
+    atomic_fetch_add(&slot->running, 1);
+    // re-checked under running, so the fields cannot be rewritten while read
+    if (atomic_load(&slot->state) == SLOT_ACTIVE && slot->node == p_node)
+    {
+      matched = 1;
+      if (slot->fn)
+      {
+        slot->fn(slot->ctx, p_node, state);
+      }
+    }
+    atomic_fetch_sub(&slot->running, 1);
+  }
+
+  // flips nobody subscribed to must not wake waiters
+  if (matched)
+  {
+    _wake();
+  }
+}
+
+/*
+ * Pairs with the fence in subscribe, between adding to the count and the
+ * consumer reading the epoch and the state: the flip wrote the state before
+ * this fence, so either the flip sees the subscriber or the subscriber sees
+ * the new state. Without the fences both loads can miss on weak-memory
+ * targets (store buffering) and a waiter sleeps through the flip, since
+ * unsubscribed flips do not advance the epoch. The state may be written with
+ * any order (the spinlock counter is relaxed), hence fences on both sides.
+ */
+static uint8_t _subscribed(const atomic_uint* const p_count)
+{
+  atomic_thread_fence(memory_order_seq_cst);
+  return atomic_load_explicit(p_count, memory_order_relaxed) != 0;
+}
+
+//internal
+
+void EmergencyNotify_led_changed(const uint8_t state)
+{
+  if (_subscribed(&NOTIFY.led_subscribers))
+  {
+    _dispatch(NULL, state);
+  }
+}
+
+void EmergencyNotify_node_edge(const EmergencyNodeAtomic_t* const p_node, const uint8_t state)
+{
+  if (_subscribed(&NOTIFY.node_subscribers))
+  {
+    _dispatch(p_node, state);
+  }
+}
+
+//public
+
+int8_t EmergencyNotify_subscribe(const EmergencyNodeAtomic_t* const p_node, const EmergencyNotify_fn fn,
+    void* const ctx)
+{
+  for (uint8_t i = 0; i < EMERGENCY_NOTIFY_SUBSCRIBERS; i++)
+  {
+    NotifySlot* const slot = &NOTIFY.slot[i];
+    unsigned expected = SLOT_FREE;
+    if (!atomic_compare_exchange_strong(&slot->state, &expected, SLOT_CLAIMED))
+    {
+      continue;
+    }
+
+    slot->node = p_node;
+    slot->fn = fn;
+    slot->ctx = ctx;
+    atomic_fetch_add(p_node ? &NOTIFY.node_subscribers : &NOTIFY.led_subscribers, 1);
+    atomic_store(&slot->state, SLOT_ACTIVE);
+    // the other half of _subscribed: the caller reads the state after this
+    atomic_thread_fence(memory_order_seq_cst);
+    return (int8_t) i;
+  }
+
+  return -1;
+}
+
+int8_t EmergencyNotify_unsubscribe(const int8_t id)
+{
+  if (id < 0 || id >= EMERGENCY_NOTIFY_SUBSCRIBERS)
+  {
+    return -1;
+  }
+
+  NotifySlot* const slot = &NOTIFY.slot[id];
+  unsigned expected = SLOT_ACTIVE;
+  if (!atomic_compare_exchange_strong(&slot->state, &expected, SLOT_CLAIMED))
+  {
+    return -1;
+  }
+
+  atomic_fetch_sub(slot->node ? &NOTIFY.node_subscribers : &NOTIFY.led_subscribers, 1);
+  while (atomic_load(&slot->running));
+  atomic_store(&slot->state, SLOT_FREE);
+
+  return 0;
+}
+
+uint32_t EmergencyNotify_epoch(void)
+{
+  return atomic_load(&NOTIFY.epoch);
+}
+
+int8_t EmergencyNotify_wait(const uint32_t epoch, const uint32_t timeout_ms)
+{
+  struct timespec deadline;
+#ifdef __linux__
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+#else
+  // the clock pthread_cond_timedwait measures against
+  clock_gettime(CLOCK_REALTIME, &deadline);
+#endif
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (long) (timeout_ms % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000)
+  {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  int8_t res = 0;
+  atomic_fetch_add(&NOTIFY.waiters, 1);
+#ifdef __linux__
+  while (atomic_load(&NOTIFY.epoch) == epoch)
+  {
+    struct timespec remaining = {0, 0};
+    if (timeout_ms)
+    {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+      remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+      if (remaining.tv_nsec < 0)
+      {
+        remaining.tv_sec--;
+        remaining.tv_nsec += 1000000000;
+      }
+      if (remaining.tv_sec < 0)
+      {
+        res = -1;
+        break;
+      }
+    }
+    // returns at once if the epoch moved after the check above
+    syscall(SYS_futex, &NOTIFY.epoch, FUTEX_WAIT_PRIVATE, epoch, timeout_ms ? &remaining : NULL, NULL, 0);
+  }
+#else
+  pthread_mutex_lock(&NOTIFY.mutex);
+  while (atomic_load(&NOTIFY.epoch) == epoch)
+  {
+    if (!timeout_ms)
+    {
+      pthread_cond_wait(&NOTIFY.cond, &NOTIFY.mutex);
+    }
+    else if (pthread_cond_timedwait(&NOTIFY.cond, &NOTIFY.mutex, &deadline))
+    {
+      res = atomic_load(&NOTIFY.epoch) == epoch ? -1 : 0;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&NOTIFY.mutex);
+#endif
+  atomic_fetch_sub(&NOTIFY.waiters, 1);
+
+  return res;
+}
@@ -0,0 +1,42 @@
+#ifndef __EMERGENCY_NOTIFY__
+#define __EMERGENCY_NOTIFY__
+
+#include "./emergency_module.h"
+
+/*
+ * Change notification instead of polling.
+ *
+ * A subscription on NULL fires on every flip of the global LED state; one on
+ * an EmergencyNodeAtomic_t fires on every 0<->1 edge of that node. The
+ * callback runs on the thread that caused the flip, after the module
+ * released its lock, and must not block; it may be NULL for waiters only.
+ *
+ * Every notification also advances an epoch that EmergencyNotify_wait sleeps
+ * on (a futex on Linux, a condition variable elsewhere): a consumer
+ * subscribes (fn may be NULL), reads the epoch, checks the state and sleeps
+ * until something it subscribed to changed. Only subscribed flips advance
+ * the epoch. Flips from different threads can be delivered out of order:
+ * callbacks get the state they caused, consumers that need the current one
+ * read it again. A flip that lands while a consumer subscribes either is
+ * notified or is already visible to the consumer's check after subscribe
+ * returns. Without any subscriber a flip costs one fence and one load.
+ */
+
+#ifndef EMERGENCY_NOTIFY_SUBSCRIBERS
+#define EMERGENCY_NOTIFY_SUBSCRIBERS 16
+#endif
+
+typedef void (*EmergencyNotify_fn)(void* const ctx, const void* const p_node, const uint8_t state);
+
+// subscription id, or -1 when all EMERGENCY_NOTIFY_SUBSCRIBERS slots are taken
+int8_t EmergencyNotify_subscribe(const EmergencyNodeAtomic_t* const p_node, const EmergencyNotify_fn fn,
+    void* const ctx);
+
+int8_t EmergencyNotify_unsubscribe(const int8_t id);
+
+uint32_t EmergencyNotify_epoch(void);
+
+// 0 once the epoch differs from epoch, -1 after timeout_ms (0: wait forever)
+int8_t EmergencyNotify_wait(const uint32_t epoch, const uint32_t timeout_ms);
+
+#endif // !__EMERGENCY_NOTIFY__
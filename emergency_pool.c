@@ -0,0 +1,139 @@
+#include "./emergency_pool.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+//private
+
+#define POOL_END UINT32_MAX
+
+static inline size_t _round_line(const size_t size)
+{
+  return (size + EMERGENCY_CACHE_LINE - 1) & ~(size_t) (EMERGENCY_CACHE_LINE - 1);
+}
+
+static inline uint_fast64_t _head(const uint_fast64_t old_head, const uint32_t index)
+{
+  // a new tag on every change, so a pop cannot succeed on a head that was popped and pushed back
+  return (((old_head >> 32) + 1) << 32) | index;
+}
+
+static void _push(EmergencyNodePool_t* const restrict p_self, const uint32_t index)
+{
+  uint_fast64_t head = atomic_load_explicit(&p_self->free_head, memory_order_relaxed);
+  do
+  {
+    atomic_store_explicit(&p_self->next[index], (uint32_t) head, memory_order_relaxed);
+  } while (!atomic_compare_exchange_weak_explicit(&p_self->free_head, &head, _head(head, index),
+      memory_order_release, memory_order_relaxed));
+}
+
+//public
+
+int8_t EmergencyNodePool_create(EmergencyNodePool_t* const restrict p_self, const uint32_t capacity)
+{
+  memset(p_self, 0, sizeof(*p_self));
+  if (!capacity || capacity > INT32_MAX)
+  {
+    return -1;
+  }
+
+  const size_t words = ((size_t) capacity + 63) / 64;
+  const size_t nodes_size = _round_line((size_t) capacity * sizeof(EmergencyNode_t));
+  const size_t allocated_size = _round_line(words * sizeof(atomic_uint_fast64_t));
+  const size_t next_size = _round_line((size_t) capacity * sizeof(atomic_uint_least32_t));
+
+#ifdef _WIN32
+  uint8_t* const arena = _aligned_malloc(nodes_size + allocated_size + next_size, EMERGENCY_CACHE_LINE);
+#else
+  uint8_t* const arena = aligned_alloc(EMERGENCY_CACHE_LINE, nodes_size + allocated_size + next_size);
+#endif
+  if (!arena)
+  {
+    return -1;
+  }
+
+  memset(arena, 0, nodes_size + allocated_size + next_size);
+  p_self->arena = arena;
+  p_self->nodes = (EmergencyNode_t*) arena;
+  p_self->allocated = (atomic_uint_fast64_t*) (arena + nodes_size);
+  p_self->next = (atomic_uint_least32_t*) (arena + nodes_size + allocated_size);
+  p_self->capacity = capacity;
+
+  EmergencyNode_init_range(p_self->nodes, capacity);
+  for (uint32_t i = 0; i < capacity; i++)
+  {
+    atomic_init(&p_self->next[i], i + 1 < capacity ? i + 1 : POOL_END);
+  }
+  atomic_init(&p_self->free_head, 0);
+
+  return 0;
+}
+
+int8_t EmergencyNodePool_destroy(EmergencyNodePool_t* const restrict p_self)
+{
+  EmergencyNode_destroy_range(p_self->nodes, p_self->capacity);
+
+#ifdef _WIN32
+  _aligned_free(p_self->arena);
+#else
+  free(p_self->arena);
+#endif
+  memset(p_self, 0, sizeof(*p_self));
+
+  return 0;
+}
+
+int32_t EmergencyNodePool_acquire(EmergencyNodePool_t* const restrict p_self)
+{
+  uint_fast64_t head = atomic_load_explicit(&p_self->free_head, memory_order_acquire);
+  uint32_t index;
+  for (;;)
+  {
+    index = (uint32_t) head;
+    if (index == POOL_END)
+    {
+      return -1;
+    }
+
+    // may be stale when another thread took index meanwhile; the tag makes the exchange fail then
+    const uint32_t next = atomic_load_explicit(&p_self->next[index], memory_order_relaxed);
+    if (atomic_compare_exchange_weak_explicit(&p_self->free_head, &head, _head(head, next),
+        memory_order_acquire, memory_order_acquire))
+    {
+      break;
+    }
+  }
+
+  atomic_fetch_or_explicit(&p_self->allocated[index / 64], UINT64_C(1) << (index % 64), memory_order_relaxed);
+
+  return (int32_t) index;
+}
+
+int8_t EmergencyNodePool_release(EmergencyNodePool_t* const restrict p_self, const int32_t handle)
+{
+  if (handle < 0 || (uint32_t) handle >= p_self->capacity)
+  {
+    return -1;
+  }
+
+  const uint_fast64_t bit = UINT64_C(1) << (handle % 64);
+  if (!(atomic_fetch_and_explicit(&p_self->allocated[handle / 64], ~bit, memory_order_relaxed) & bit))
+  {
+    return -1;
+  }
+
+  // the next owner gets a clear node
+  EmergencyNode_destroy(&p_self->nodes[handle]);
+  _push(p_self, (uint32_t) handle);
+
+  return 0;
+}
+
+int8_t EmergencyNodePool_collect_active(const EmergencyNodePool_t* const restrict p_self,
+    EmergencyActiveReport_t* const restrict out)
+{
+  return EmergencyNode_collect_active(p_self->nodes, p_self->capacity, out);
+}
@@ -0,0 +1,60 @@
+#ifndef __EMERGENCY_POOL__
+#define __EMERGENCY_POOL__
+
+#include "./emergency_module.h"
+#include "./emergency_scan.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * Fixed-capacity pool of plain nodes, allocated once at startup.
+ *
+ * The pool keeps its parts as separate arrays in one arena: the nodes back
+ * to back (in the default build just the exception words, since a node's
+ * counter is the popcount of its word), one allocation bit per node and the
+ * free list links. Scans and snapshots over the pool therefore read only
+ * node words, sequentially; free nodes are clear and never show up as active.
+ *
+ * acquire/release take and return a node handle in O(1) on a lock-free free
+ * list and never allocate; both may be called from any thread. An acquired
+ * node is driven through EmergencyNodePool_node with the EmergencyNode_*
+ * calls, by one thread at a time like any plain node.
+ */
+
+typedef struct {
+  EmergencyNode_t* nodes;
+  atomic_uint_fast64_t* allocated;
+  atomic_uint_least32_t* next;
+  // free list head: node index in the low half, ABA tag in the high half
+  atomic_uint_fast64_t free_head __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  void* arena;
+  uint32_t capacity;
+}EmergencyNodePool_t;
+
+static inline EmergencyNode_t*
+EmergencyNodePool_node(const EmergencyNodePool_t* const restrict p_self, const int32_t handle)
+{
+  return &p_self->nodes[handle];
+}
+
+// the pool's only allocation; capacity 1 .. INT32_MAX
+int8_t
+EmergencyNodePool_create(EmergencyNodePool_t* const restrict, const uint32_t capacity)__attribute__((__nonnull__(1)));
+
+// destroys every node, acquired or not, and releases the arena
+int8_t
+EmergencyNodePool_destroy(EmergencyNodePool_t* const restrict)__attribute__((__nonnull__(1)));
+
+// handle of a clear node, -1 when every node is acquired
+int32_t
+EmergencyNodePool_acquire(EmergencyNodePool_t* const restrict)__attribute__((__nonnull__(1)));
+
+// destroys the node and frees its handle; -1 for handles that are not acquired
+int8_t
+EmergencyNodePool_release(EmergencyNodePool_t* const restrict, const int32_t handle)__attribute__((__nonnull__(1)));
+
+// EmergencyNode_collect_active over the pool; the indices are handles
+int8_t EmergencyNodePool_collect_active(const EmergencyNodePool_t* const restrict p_self,
+    EmergencyActiveReport_t* const restrict out)__attribute__((__nonnull__(1, 2)));
+
+#endif // !__EMERGENCY_POOL__
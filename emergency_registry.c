@@ -0,0 +1,319 @@
+#include "./emergency_registry.h"
+#include "./emergency_export.h"
+#include "./emergency_internal.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#ifdef EMERGENCY_EXPORT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//private
+
+static EmergencyRegistryLayout_t REGISTRY_STORAGE = {
+  .magic = EMERGENCY_EXPORT_MAGIC,
+  .version = EMERGENCY_EXPORT_VERSION,
+  .capacity = EMERGENCY_REGISTRY_CAPACITY,
+  .node_size = sizeof(EmergencyNodeAtomic_t),
+  .layout_size = sizeof(EmergencyRegistryLayout_t),
+};
+
+// static storage, or the shared segment once exported
+static EmergencyRegistryLayout_t* _Atomic REGISTRY = &REGISTRY_STORAGE;
+
+static inline EmergencyRegistryLayout_t* _registry(void)
+{
+  return atomic_load_explicit(&REGISTRY, memory_order_acquire);
+}
+
+_Static_assert(EMERGENCY_REGISTRY_CAPACITY % 64 == 0, "registry capacity must be a multiple of 64");
+_Static_assert(EMERGENCY_REGISTRY_WORDS <= 64, "summary_words keeps one bit per summary word");
+
+static inline EmergencyRegistryWindow_t* _window_of(const uint16_t index)
+{
+  return &_registry()->window[index / EMERGENCY_REGISTRY_GROUP_NODES];
+}
+
+static inline void _window_begin(const uint16_t index)
+{
+  atomic_fetch_add(&_window_of(index)->write_begin, 1);
+}
+
+static inline void _window_end(const uint16_t index)
+{
+  atomic_fetch_add_explicit(&_window_of(index)->write_end, 1, memory_order_release);
+}
+
+static inline void _set_summary(const uint16_t index)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  const uint16_t word = index / 64;
+  const uint_fast64_t bit = UINT64_C(1) << (index % 64);
+
+  if (!atomic_fetch_or(&registry->summary[word], bit))
+  {
+    atomic_fetch_or(&registry->summary_words, UINT64_C(1) << word);
+  }
+}
+
+static inline void _clear_summary(const uint16_t index)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  const uint16_t word = index / 64;
+  const uint_fast64_t bit = UINT64_C(1) << (index % 64);
+
+  if (atomic_fetch_and(&registry->summary[word], ~bit) == bit)
+  {
+    atomic_fetch_and(&registry->summary_words, ~(UINT64_C(1) << word));
+    // another node of this word may have been set in between
+    if (atomic_load(&registry->summary[word]))
+    {
+      atomic_fetch_or(&registry->summary_words, UINT64_C(1) << word);
+    }
+  }
+}
+
+//internal
+
+/*
+ * The raise that opened an edge and the solve that closed it can reach this
+ * point in either order, so the summary bit is written from the node's
+ * current state and re-checked afterwards, like emergency_led.
+ */
+void EmergencyRegistry_node_edge(const EmergencyNodeAtomic_t* const p_node)
+{
+  const int16_t index = EmergencyRegistry_index(p_node);
+  if (index < 0)
+  {
+    return;
+  }
+
+  uint8_t active = atomic_load(&p_node->emergency_buffer) != 0;
+  for (;;)
+  {
+    if (active)
+    {
+      _set_summary((uint16_t) index);
+    }
+    else
+    {
+      _clear_summary((uint16_t) index);
+    }
+
+    const uint8_t now = atomic_load(&p_node->emergency_buffer) != 0;
+    if (now == active)
+    {
+      break;
+    }
+    active = now;
+  }
+}
+
+int16_t EmergencyRegistry_write_begin(const EmergencyNodeAtomic_t* const p_node)
+{
+  const int16_t index = EmergencyRegistry_index(p_node);
+  if (index >= 0)
+  {
+    _window_begin((uint16_t) index);
+  }
+  return index;
+}
+
+void EmergencyRegistry_write_end(const int16_t index)
+{
+  if (index >= 0)
+  {
+    _window_end((uint16_t) index);
+  }
+}
+
+#ifdef EMERGENCY_EXPORT
+atomic_int_least32_t* _Atomic EmergencyExport_counter_mirror;
+
+// sum of the edges no mirror has seen yet
+static atomic_int_least32_t EXPORT_UNPUBLISHED;
+
+/*
+ * The edge adds to EXPORT_UNPUBLISHED before it reloads the mirror, the
+ * export publishes the mirror before it takes EXPORT_UNPUBLISHED, both
+ * seq_cst: whichever runs second moves the edge into the segment, and the
+ * exchange hands every unit over only once.
+ */
+void EmergencyExport_counter_unpublished(const int32_t delta)
+{
+  atomic_fetch_add(&EXPORT_UNPUBLISHED, delta);
+  atomic_int_least32_t* const mirror = atomic_load(&EmergencyExport_counter_mirror);
+  if (mirror)
+  {
+    atomic_fetch_add_explicit(mirror, atomic_exchange(&EXPORT_UNPUBLISHED, 0), memory_order_relaxed);
+  }
+}
+#endif
+
+//public
+
+EmergencyNodeAtomic_t* EmergencyRegistry_acquire(void)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  EmergencyNodeAtomic_t* p_node = NULL;
+
+  for (uint16_t word = 0; word < EMERGENCY_REGISTRY_WORDS && !p_node; word++)
+  {
+    uint_fast64_t allocated = atomic_load(&registry->allocated[word]);
+    while (~allocated)
+    {
+      const uint_fast64_t bit = ~allocated & (allocated + 1);
+      if (atomic_compare_exchange_weak(&registry->allocated[word], &allocated, allocated | bit))
+      {
+        // a released node is already clear, so a copy seeing the claim before the init stays consistent
+        const uint16_t index = (uint16_t) (word * 64 + __builtin_ctzll(bit));
+        p_node = &registry->nodes[index];
+        _window_begin(index);
+        EmergencyNodeAtomic_init(p_node);
+        _window_end(index);
+        break;
+      }
+    }
+  }
+
+  return p_node;
+}
+
+int8_t EmergencyRegistry_release(EmergencyNodeAtomic_t* const restrict p_node)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  const int16_t index = EmergencyRegistry_index(p_node);
+  if (index < 0)
+  {
+    return -1;
+  }
+
+  const uint_fast64_t bit = UINT64_C(1) << (index % 64);
+  if (!(atomic_load(&registry->allocated[index / 64]) & bit))
+  {
+    return -1;
+  }
+
+  EmergencyNodeAtomic_destroy(p_node);
+  _window_begin((uint16_t) index);
+  atomic_fetch_and(&registry->allocated[index / 64], ~bit);
+  _window_end((uint16_t) index);
+
+  return 0;
+}
+
+int16_t EmergencyRegistry_index(const EmergencyNodeAtomic_t* const p_node)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  const uintptr_t offset = (uintptr_t) p_node - (uintptr_t) registry->nodes;
+  if (offset >= sizeof(registry->nodes) || offset % sizeof(registry->nodes[0]))
+  {
+    return -1;
+  }
+
+  return (int16_t) (offset / sizeof(registry->nodes[0]));
+}
+
+EmergencyNodeAtomic_t* EmergencyRegistry_node(const uint16_t index)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  if (index >= EMERGENCY_REGISTRY_CAPACITY)
+  {
+    return NULL;
+  }
+
+  return &registry->nodes[index];
+}
+
+uint8_t EmergencyRegistry_any_emergency(void)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  return atomic_load(&registry->summary_words) != 0;
+}
+
+int16_t EmergencyRegistry_next_emergency(const uint16_t from)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  if (from >= EMERGENCY_REGISTRY_CAPACITY)
+  {
+    return -1;
+  }
+
+  uint_fast64_t words = atomic_load(&registry->summary_words) & (UINT64_MAX << (from / 64));
+  while (words)
+  {
+    const uint16_t word = (uint16_t) __builtin_ctzll(words);
+    uint_fast64_t bits = atomic_load(&registry->summary[word]);
+    if (word == from / 64)
+    {
+      bits &= UINT64_MAX << (from % 64);
+    }
+    if (bits)
+    {
+      return (int16_t) (word * 64 + __builtin_ctzll(bits));
+    }
+    words &= words - 1;
+  }
+
+  return -1;
+}
+
+int8_t EmergencySystem_snapshot(EmergencySystemSnapshot_t* const restrict out_buf)
+{
+  return EmergencyExport_read_using(_registry(), out_buf, EmergencyNode_global_counter_unlocked);
+}
+
+#ifdef EMERGENCY_EXPORT
+int8_t EmergencyRegistry_export(const char* const name)
+{
+  EmergencyRegistryLayout_t* const registry = _registry();
+  if (registry != &REGISTRY_STORAGE)
+  {
+    return -1;
+  }
+  for (uint16_t word = 0; word < EMERGENCY_REGISTRY_WORDS; word++)
+  {
+    if (atomic_load(&registry->allocated[word]))
+    {
+      return -1;
+    }
+  }
+
+  // never reuse a segment that another process may still map
+  const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0)
+  {
+    return -1;
+  }
+  if (ftruncate(fd, sizeof(EmergencyRegistryLayout_t)))
+  {
+    close(fd);
+    shm_unlink(name);
+    return -1;
+  }
+  EmergencyRegistryLayout_t* const segment =
+    mmap(NULL, sizeof(EmergencyRegistryLayout_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (segment == MAP_FAILED)
+  {
+    shm_unlink(name);
+    return -1;
+  }
+
+  // a new segment reads as zero, as does the registry with no node acquired
+  segment->capacity = EMERGENCY_REGISTRY_CAPACITY;
+  segment->node_size = sizeof(EmergencyNodeAtomic_t);
+  segment->layout_size = sizeof(EmergencyRegistryLayout_t);
+  segment->version = EMERGENCY_EXPORT_VERSION;
+  // every edge so far is in EXPORT_UNPUBLISHED or will go to the mirror
+  atomic_store(&EmergencyExport_counter_mirror, &segment->global_counter);
+  atomic_fetch_add_explicit(&segment->global_counter, atomic_exchange(&EXPORT_UNPUBLISHED, 0), memory_order_relaxed);
+  atomic_store_explicit(&REGISTRY, segment, memory_order_release);
+  // readers check the magic last
+  atomic_store_explicit(&segment->magic, EMERGENCY_EXPORT_MAGIC, memory_order_release);
+
+  return 0;
+}
+#endif
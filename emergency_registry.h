@@ -0,0 +1,35 @@
+#ifndef __EMERGENCY_REGISTRY__
+#define __EMERGENCY_REGISTRY__
+
+#include "./emergency_module.h"
+
+/*
+ * Global registry of concurrent nodes.
+ *
+ * Registered nodes live in the registry's own storage and are handed out by
+ * EmergencyRegistry_acquire; they are driven with the EmergencyNodeAtomic_*
+ * calls like any other node. Every 0<->1 edge of a registered node keeps a
+ * summary bitmap (one bit per node, plus one bit per summary word) up to
+ * date, so "is any registered node in emergency" is a single load and
+ * "which nodes" is a find-first-set over the summary.
+ */
+
+#define EMERGENCY_REGISTRY_CAPACITY 512
+#define EMERGENCY_REGISTRY_WORDS (EMERGENCY_REGISTRY_CAPACITY / 64)
+
+EmergencyNodeAtomic_t* EmergencyRegistry_acquire(void);
+
+int8_t
+EmergencyRegistry_release(EmergencyNodeAtomic_t* const restrict)__attribute__((__nonnull__(1)));
+
+// index of a registered node, -1 for any other node
+int16_t EmergencyRegistry_index(const EmergencyNodeAtomic_t* const);
+
+EmergencyNodeAtomic_t* EmergencyRegistry_node(const uint16_t index);
+
+uint8_t EmergencyRegistry_any_emergency(void);
+
+// first registered node in emergency with index >= from, -1 when there is none
+int16_t EmergencyRegistry_next_emergency(const uint16_t from);
+
+#endif // !__EMERGENCY_REGISTRY__
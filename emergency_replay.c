@@ -0,0 +1,240 @@
+#include "./emergency_replay.h"
+#include <stdatomic.h>
+#include <string.h>
+
+//private
+
+_Static_assert(NUM_EMERGENCY_WORDS == 1, "the replay model keeps one exception word per node");
+_Static_assert(EMERGENCY_REPLAY_NODES >= 1 && EMERGENCY_REPLAY_NODES < EMERGENCY_REPLAY_ATOMIC,
+    "replay node index must fit below the atomic flag");
+
+#ifndef EMERGENCY_DEFERRED_LED
+extern atomic_ushort emergency_led;
+#endif
+
+// replay nodes and the bits every op must leave on them
+static struct{
+  EmergencyNode_t plain[EMERGENCY_REPLAY_NODES];
+  EmergencyNodeAtomic_t atomic[EMERGENCY_REPLAY_NODES];
+  uint64_t model[2][EMERGENCY_REPLAY_NODES];
+}REPLAY;
+
+// raw op kinds, weighted towards raises so nodes spend time in emergency
+static const uint8_t DECODE_KIND[8] = {
+  EMERGENCY_REPLAY_RAISE, EMERGENCY_REPLAY_RAISE, EMERGENCY_REPLAY_RAISE,
+  EMERGENCY_REPLAY_SOLVE, EMERGENCY_REPLAY_SOLVE,
+  EMERGENCY_REPLAY_RAISE_MASK, EMERGENCY_REPLAY_SOLVE_MASK,
+  EMERGENCY_REPLAY_DESTROY,
+};
+
+static void _nodes_init(void)
+{
+  EmergencyNode_init_range(REPLAY.plain, EMERGENCY_REPLAY_NODES);
+  for (uint8_t i = 0; i < EMERGENCY_REPLAY_NODES; i++)
+  {
+    EmergencyNodeAtomic_init(&REPLAY.atomic[i]);
+  }
+  memset(REPLAY.model, 0, sizeof(REPLAY.model));
+}
+
+static void _nodes_destroy(void)
+{
+  EmergencyNode_destroy_range(REPLAY.plain, EMERGENCY_REPLAY_NODES);
+  for (uint8_t i = 0; i < EMERGENCY_REPLAY_NODES; i++)
+  {
+    EmergencyNodeAtomic_destroy(&REPLAY.atomic[i]);
+  }
+}
+
+// applies op to its node and to the model; *p_expected is what the call must return
+static int8_t _apply(const EmergencyReplayOp_t* const restrict op, const uint8_t atomic, const uint8_t index,
+    int8_t* const restrict p_expected)
+{
+  uint64_t* const model = &REPLAY.model[atomic][index];
+  EmergencyNode_t* const plain = &REPLAY.plain[index];
+  EmergencyNodeAtomic_t* const shared = &REPLAY.atomic[index];
+  const uint8_t valid_exception = op->exception < NUM_EMERGENCY_BUFFER * 8;
+  const uint8_t valid_mask = !(op->mask & ~EMERGENCY_MASK_VALID);
+
+  switch (op->kind)
+  {
+    case EMERGENCY_REPLAY_RAISE:
+      *p_expected = valid_exception ? 0 : -1;
+      *model |= valid_exception ? UINT64_C(1) << op->exception : 0;
+      return atomic ? EmergencyNodeAtomic_raise(shared, op->exception) : EmergencyNode_raise(plain, op->exception);
+    case EMERGENCY_REPLAY_SOLVE:
+      *p_expected = valid_exception ? 0 : -1;
+      *model &= valid_exception ? ~(UINT64_C(1) << op->exception) : UINT64_MAX;
+      return atomic ? EmergencyNodeAtomic_solve(shared, op->exception) : EmergencyNode_solve(plain, op->exception);
+    case EMERGENCY_REPLAY_RAISE_MASK:
+      *p_expected = valid_mask ? 0 : -1;
+      *model |= valid_mask ? op->mask : 0;
+      return atomic ? EmergencyNodeAtomic_raise_mask(shared, op->mask) : EmergencyNode_raise_mask(plain, op->mask);
+    case EMERGENCY_REPLAY_SOLVE_MASK:
+      *p_expected = valid_mask ? 0 : -1;
+      *model &= valid_mask ? ~op->mask : UINT64_MAX;
+      return atomic ? EmergencyNodeAtomic_solve_mask(shared, op->mask) : EmergencyNode_solve_mask(plain, op->mask);
+    default:
+      *p_expected = 0;
+      *model = 0;
+      return atomic ? EmergencyNodeAtomic_destroy(shared) : EmergencyNode_destroy(plain);
+  }
+}
+
+// first invariant broken after an op on the given node, or EMERGENCY_REPLAY_OK
+static uint8_t _check(const EmergencyReplayOp_t* const restrict op, const uint8_t atomic, const uint8_t index,
+    const int32_t expected_global)
+{
+  const uint64_t word = atomic ? atomic_load(&REPLAY.atomic[index].emergency_buffer)
+    : REPLAY.plain[index].emergency_buffer[0];
+  if (word != REPLAY.model[atomic][index])
+  {
+    return EMERGENCY_REPLAY_MODEL;
+  }
+
+  const uint32_t counter = atomic ? EmergencyNodeAtomic_counter(&REPLAY.atomic[index])
+    : EmergencyNode_counter(&REPLAY.plain[index]);
+  if (counter != (uint32_t) __builtin_popcountll(word))
+  {
+    return EMERGENCY_REPLAY_NODE_COUNTER;
+  }
+  if (op->expected != EMERGENCY_REPLAY_UNCHECKED && counter != op->expected)
+  {
+    return EMERGENCY_REPLAY_RECORDED_COUNTER;
+  }
+
+  const int32_t global = EmergencyNode_global_counter();
+  if (global != expected_global)
+  {
+    return EMERGENCY_REPLAY_GLOBAL_COUNTER;
+  }
+#ifndef EMERGENCY_DEFERRED_LED
+  if ((atomic_load(&emergency_led) != 0) != (global > 0))
+  {
+    return EMERGENCY_REPLAY_LED;
+  }
+#endif
+
+  return EMERGENCY_REPLAY_OK;
+}
+
+//public
+
+int8_t EmergencyReplay_run(const EmergencyReplayOp_t* const restrict ops, const uint32_t count,
+    EmergencyReplayResult_t* const restrict p_result)
+{
+  _nodes_init();
+  p_result->ops_run = 0;
+  p_result->failed_op = 0;
+  p_result->violated = EMERGENCY_REPLAY_OK;
+
+  // nodes outside the replay keep their share of the global counter
+  const int32_t base = EmergencyNode_global_counter();
+  int32_t active = 0;
+  for (uint32_t i = 0; i < count && p_result->violated == EMERGENCY_REPLAY_OK; i++)
+  {
+    const EmergencyReplayOp_t* const op = &ops[i];
+    const uint8_t atomic = (op->node & EMERGENCY_REPLAY_ATOMIC) != 0;
+    const uint8_t index = op->node & ~EMERGENCY_REPLAY_ATOMIC;
+    p_result->ops_run++;
+    if (index >= EMERGENCY_REPLAY_NODES || op->kind > EMERGENCY_REPLAY_DESTROY)
+    {
+      p_result->failed_op = i;
+      p_result->violated = EMERGENCY_REPLAY_BAD_OP;
+      break;
+    }
+
+    const uint8_t was_active = REPLAY.model[atomic][index] != 0;
+    int8_t expected;
+    const int8_t returned = _apply(op, atomic, index, &expected);
+    active += (REPLAY.model[atomic][index] != 0) - was_active;
+
+    const uint8_t violated = returned != expected ? EMERGENCY_REPLAY_RETURN : _check(op, atomic, index, base + active);
+    if (violated != EMERGENCY_REPLAY_OK)
+    {
+      p_result->failed_op = i;
+      p_result->violated = violated;
+    }
+  }
+
+  _nodes_destroy();
+  return p_result->violated == EMERGENCY_REPLAY_OK ? 0 : -1;
+}
+
+uint32_t EmergencyReplay_decode(const uint8_t* const restrict data, const size_t size,
+    EmergencyReplayOp_t* const restrict out, const uint32_t max)
+{
+  /*
+   * byte 0: kind (3 bits), atomic set (1 bit), node (4 bits)
+   * byte 1: exception; the top 16 values stay out of range to hit the error paths
+   * bytes 2-9: mask, little endian, any 64-bit value, so masks past
+   * EMERGENCY_MASK_VALID reach the error paths of the *_mask calls
+   */
+  uint32_t n = 0;
+  for (size_t i = 0; i + EMERGENCY_REPLAY_OP_BYTES <= size && n < max; i += EMERGENCY_REPLAY_OP_BYTES)
+  {
+    const uint8_t op = data[i];
+    const uint8_t b1 = data[i + 1];
+    uint64_t mask = 0;
+    for (uint8_t b = 0; b < 8; b++)
+    {
+      mask |= (uint64_t) data[i + 2 + b] << (8 * b);
+    }
+    out[n].kind = DECODE_KIND[op >> 5];
+    out[n].node = (uint8_t) (((op & 0x0F) % EMERGENCY_REPLAY_NODES) | (op & 0x10 ? EMERGENCY_REPLAY_ATOMIC : 0));
+    out[n].exception = b1 < 0xF0 ? b1 % 64 : b1;
+    out[n].expected = EMERGENCY_REPLAY_UNCHECKED;
+    out[n].mask = mask;
+    n++;
+  }
+  return n;
+}
+
+#ifdef EMERGENCY_EVENTS
+uint32_t EmergencyReplay_record(const EmergencyEvent_t* const restrict events, const uint32_t count,
+    const EmergencyNode_t* const plain, const uint8_t plain_count,
+    const EmergencyNodeAtomic_t* const atomic, const uint8_t atomic_count,
+    EmergencyReplayOp_t* const restrict out, const uint32_t max)
+{
+  const uint8_t plain_nodes = plain_count < EMERGENCY_REPLAY_NODES ? plain_count : EMERGENCY_REPLAY_NODES;
+  const uint8_t atomic_nodes = atomic_count < EMERGENCY_REPLAY_NODES ? atomic_count : EMERGENCY_REPLAY_NODES;
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < count && n < max; i++)
+  {
+    const EmergencyEvent_t* const event = &events[i];
+    uint8_t node;
+    if (plain && event->node >= (const void*) plain && event->node < (const void*) (plain + plain_nodes))
+    {
+      node = (uint8_t) ((const EmergencyNode_t*) event->node - plain);
+    }
+    else if (atomic && event->node >= (const void*) atomic && event->node < (const void*) (atomic + atomic_nodes))
+    {
+      node = (uint8_t) ((const EmergencyNodeAtomic_t*) event->node - atomic) | EMERGENCY_REPLAY_ATOMIC;
+    }
+    else
+    {
+      continue;
+    }
+
+    out[n].node = node;
+    out[n].exception = event->exception;
+    out[n].mask = 0;
+    out[n].expected = event->node_counter < EMERGENCY_REPLAY_UNCHECKED ? (uint8_t) event->node_counter
+      : EMERGENCY_REPLAY_UNCHECKED;
+    switch (event->kind)
+    {
+      case EMERGENCY_EVENT_RAISE:
+        out[n].kind = EMERGENCY_REPLAY_RAISE;
+        break;
+      case EMERGENCY_EVENT_SOLVE:
+        out[n].kind = EMERGENCY_REPLAY_SOLVE;
+        break;
+      default:
+        out[n].kind = EMERGENCY_REPLAY_DESTROY;
+        break;
+    }
+    n++;
+  }
+  return n;
+}
+#endif // EMERGENCY_EVENTS
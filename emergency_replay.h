@@ -0,0 +1,118 @@
+#ifndef __EMERGENCY_REPLAY__
+#define __EMERGENCY_REPLAY__
+
+#include "./emergency_events.h"
+#include "./emergency_module.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Deterministic replay of raise/solve/destroy sequences, for reproducing
+ * counter drift and LED bugs found under load.
+ *
+ * A sequence is an array of ops on a fixed set of EMERGENCY_REPLAY_NODES
+ * plain and EMERGENCY_REPLAY_NODES atomic nodes owned by the replayer. It
+ * comes from the event ring of a real run (EmergencyReplay_record, with
+ * -DEMERGENCY_EVENTS) or from raw bytes (EmergencyReplay_decode, the fuzzer's
+ * input format). EmergencyReplay_run applies the ops from one thread, in
+ * order, and after every op checks, at constant cost:
+ *   - the node against a reference copy of its bits and the return value
+ *     against the one the op must give,
+ *   - the node's counter against the popcount of its bits,
+ *   - the counter recorded in the event, if the op came from the ring,
+ *   - the global counter against the number of replay nodes in emergency,
+ *   - emergency_led against the global counter (not with EMERGENCY_DEFERRED_LED).
+ * The same ops always give the same result, so a failing sequence stays a
+ * failing test. The replay nodes count towards the default context: no other
+ * thread may raise or solve there while a replay runs.
+ */
+
+#ifndef EMERGENCY_REPLAY_NODES
+#define EMERGENCY_REPLAY_NODES 8
+#endif
+
+// node field of an op on one of the atomic nodes
+#define EMERGENCY_REPLAY_ATOMIC 0x80
+// expected field of an op that has no recorded counter
+#define EMERGENCY_REPLAY_UNCHECKED 0xFF
+// bytes of raw input per op (see EmergencyReplay_decode)
+#define EMERGENCY_REPLAY_OP_BYTES 10
+
+typedef enum {
+  EMERGENCY_REPLAY_RAISE,
+  EMERGENCY_REPLAY_SOLVE,
+  EMERGENCY_REPLAY_RAISE_MASK,
+  EMERGENCY_REPLAY_SOLVE_MASK,
+  EMERGENCY_REPLAY_DESTROY,
+}EmergencyReplayKind_t;
+
+typedef struct {
+  // RAISE_MASK / SOLVE_MASK
+  uint64_t mask;
+  uint8_t kind;
+  // replay node index, | EMERGENCY_REPLAY_ATOMIC for the atomic set
+  uint8_t node;
+  // RAISE / SOLVE; ids past the node are replayed too and must fail
+  uint8_t exception;
+  // node counter after the op in the recorded run, or EMERGENCY_REPLAY_UNCHECKED
+  uint8_t expected;
+}EmergencyReplayOp_t;
+
+typedef enum {
+  EMERGENCY_REPLAY_OK,
+  EMERGENCY_REPLAY_BAD_OP,
+  EMERGENCY_REPLAY_MODEL,
+  EMERGENCY_REPLAY_RETURN,
+  EMERGENCY_REPLAY_NODE_COUNTER,
+  EMERGENCY_REPLAY_RECORDED_COUNTER,
+  EMERGENCY_REPLAY_GLOBAL_COUNTER,
+  EMERGENCY_REPLAY_LED,
+}EmergencyReplayInvariant_t;
+
+typedef struct {
+  // ops applied, including the failing one
+  uint32_t ops_run;
+  // index of the first failing op; valid when violated is not OK
+  uint32_t failed_op;
+  uint8_t violated;
+}EmergencyReplayResult_t;
+
+/*
+ * Replays count ops on freshly cleared replay nodes and clears them again at
+ * the end. Returns 0, or -1 at the first broken invariant, described in
+ * p_result.
+ */
+int8_t EmergencyReplay_run(const EmergencyReplayOp_t* const restrict ops, const uint32_t count,
+    EmergencyReplayResult_t* const restrict p_result)__attribute__((__nonnull__(3)));
+
+/*
+ * Turns EMERGENCY_REPLAY_OP_BYTES bytes into one op; any byte string is a
+ * valid sequence. Returns the number of ops written, at most max; trailing
+ * bytes are ignored.
+ */
+uint32_t EmergencyReplay_decode(const uint8_t* const restrict data, const size_t size,
+    EmergencyReplayOp_t* const restrict out, const uint32_t max);
+
+#ifdef EMERGENCY_EVENTS
+/*
+ * Converts drained events of the nodes plain[0..plain_count) and
+ * atomic[0..atomic_count) into ops on the replay nodes of the same index.
+ * Events of other nodes are skipped. Destroys become DESTROY ops and every op
+ * carries the node counter of its event. Sets stay under
+ * EMERGENCY_REPLAY_NODES nodes. Returns the number of ops written, at most max.
+ *
+ * The ring keeps the order in which producers claimed their slots, which is
+ * taken after the bit change: when several threads change the same atomic
+ * node, two of its events can sit in the ring in the opposite order of their
+ * changes. Ops are replayed in ring order, so such a recording can fail with
+ * EMERGENCY_REPLAY_RECORDED_COUNTER or EMERGENCY_REPLAY_MODEL without any
+ * bug in the module. Record runs where each node is changed from one thread
+ * at a time; edges of different nodes may interleave freely.
+ */
+uint32_t EmergencyReplay_record(const EmergencyEvent_t* const restrict events, const uint32_t count,
+    const EmergencyNode_t* const plain, const uint8_t plain_count,
+    const EmergencyNodeAtomic_t* const atomic, const uint8_t atomic_count,
+    EmergencyReplayOp_t* const restrict out, const uint32_t max)__attribute__((__nonnull__(1)));
+#endif
+
+#endif // !__EMERGENCY_REPLAY__
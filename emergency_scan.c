@@ -0,0 +1,280 @@
+#include "./emergency_scan.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+//private
+
+_Static_assert(NUM_EMERGENCY_WORDS == 1, "the scan kernels read one exception word per node");
+
+// the vector kernels need the words back to back, i.e. nodes without a context pointer
+#define SCAN_WORDS_PACKED (sizeof(EmergencyNode_t) == sizeof(uint64_t))
+
+typedef void (*ScanFn)(const uint64_t* const restrict words, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out);
+
+static atomic_uint_fast8_t SELECTED = EMERGENCY_SCAN_AUTO;
+
+static inline void _emit(EmergencyActiveReport_t* const restrict out, const uint32_t index, const uint64_t word)
+{
+  if (out->count < out->capacity)
+  {
+    out->indices[out->count] = index;
+  }
+  out->count++;
+  out->exceptions += (uint32_t) __builtin_popcountll(word);
+  out->union_mask |= word;
+}
+
+static void _scan_range(const uint64_t* const restrict words, uint32_t i, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out)
+{
+  for (; i < n; i++)
+  {
+    if (words[i])
+    {
+      _emit(out, i, words[i]);
+    }
+  }
+}
+
+static void _scan_scalar(const uint64_t* const restrict words, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out)
+{
+  uint32_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const uint64_t any = (words[i] | words[i + 1]) | (words[i + 2] | words[i + 3]) |
+      (words[i + 4] | words[i + 5]) | (words[i + 6] | words[i + 7]);
+    if (any)
+    {
+      _scan_range(words, i, i + 8, out);
+    }
+  }
+  _scan_range(words, i, n, out);
+}
+
+static void _scan_strided(const uint8_t* const restrict base, const uint32_t n, const uint32_t stride,
+    EmergencyActiveReport_t* const restrict out)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const uint64_t word = ((const EmergencyNode_t*) (base + (size_t) i * stride))->emergency_buffer[0];
+    if (word)
+    {
+      _emit(out, i, word);
+    }
+  }
+}
+
+#if defined(__x86_64__)
+
+// SSE2 is part of x86-64, so this one needs no check
+static void _scan_sse2(const uint64_t* const restrict words, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out)
+{
+  const __m128i zero = _mm_setzero_si128();
+  uint32_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m128i a = _mm_loadu_si128((const __m128i*) (words + i));
+    const __m128i b = _mm_loadu_si128((const __m128i*) (words + i + 2));
+    const __m128i c = _mm_loadu_si128((const __m128i*) (words + i + 4));
+    const __m128i d = _mm_loadu_si128((const __m128i*) (words + i + 6));
+    const __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, zero)) != 0xFFFF)
+    {
+      _scan_range(words, i, i + 8, out);
+    }
+  }
+  _scan_range(words, i, n, out);
+}
+
+__attribute__((__target__("avx2")))
+static uint32_t _live_lanes(const __m256i v)
+{
+  // one bit per non-zero word
+  return ~(uint32_t) _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, _mm256_setzero_si256()))) & 0xF;
+}
+
+__attribute__((__target__("avx2")))
+static void _scan_avx2(const uint64_t* const restrict words, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out)
+{
+  uint32_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m256i a = _mm256_loadu_si256((const __m256i*) (words + i));
+    const __m256i b = _mm256_loadu_si256((const __m256i*) (words + i + 4));
+    const __m256i c = _mm256_loadu_si256((const __m256i*) (words + i + 8));
+    const __m256i d = _mm256_loadu_si256((const __m256i*) (words + i + 12));
+    const __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+    if (_mm256_testz_si256(any, any))
+    {
+      continue;
+    }
+
+    uint32_t live = _live_lanes(a) | _live_lanes(b) << 4 | _live_lanes(c) << 8 | _live_lanes(d) << 12;
+    while (live)
+    {
+      const uint32_t j = i + (uint32_t) __builtin_ctz(live);
+      _emit(out, j, words[j]);
+      live &= live - 1;
+    }
+  }
+  _scan_range(words, i, n, out);
+}
+
+#elif defined(__aarch64__)
+
+// NEON is part of AArch64, so this one needs no check
+static void _scan_neon(const uint64_t* const restrict words, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out)
+{
+  uint32_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const uint64x2_t a = vld1q_u64(words + i);
+    const uint64x2_t b = vld1q_u64(words + i + 2);
+    const uint64x2_t c = vld1q_u64(words + i + 4);
+    const uint64x2_t d = vld1q_u64(words + i + 6);
+    const uint64x2_t any = vorrq_u64(vorrq_u64(a, b), vorrq_u64(c, d));
+    if (vmaxvq_u32(vreinterpretq_u32_u64(any)))
+    {
+      _scan_range(words, i, i + 8, out);
+    }
+  }
+  _scan_range(words, i, n, out);
+}
+
+#endif
+
+static uint8_t _supported(const EmergencyScanKernel_t kernel)
+{
+  switch (kernel)
+  {
+    case EMERGENCY_SCAN_AUTO:
+    case EMERGENCY_SCAN_SCALAR:
+      return 1;
+#if defined(__x86_64__)
+    case EMERGENCY_SCAN_SSE2:
+      return 1;
+    case EMERGENCY_SCAN_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") ? 1 : 0;
+#elif defined(__aarch64__)
+    case EMERGENCY_SCAN_NEON:
+      return 1;
+#endif
+    default:
+      return 0;
+  }
+}
+
+static EmergencyScanKernel_t _best(void)
+{
+#if defined(__x86_64__)
+  return _supported(EMERGENCY_SCAN_AVX2) ? EMERGENCY_SCAN_AVX2 : EMERGENCY_SCAN_SSE2;
+#elif defined(__aarch64__)
+  return EMERGENCY_SCAN_NEON;
+#else
+  return EMERGENCY_SCAN_SCALAR;
+#endif
+}
+
+static ScanFn _kernel_fn(const EmergencyScanKernel_t kernel)
+{
+  switch (kernel)
+  {
+#if defined(__x86_64__)
+    case EMERGENCY_SCAN_SSE2:
+      return _scan_sse2;
+    case EMERGENCY_SCAN_AVX2:
+      return _scan_avx2;
+#elif defined(__aarch64__)
+    case EMERGENCY_SCAN_NEON:
+      return _scan_neon;
+#endif
+    default:
+      return _scan_scalar;
+  }
+}
+
+static void _report_reset(EmergencyActiveReport_t* const restrict out)
+{
+  out->count = 0;
+  out->exceptions = 0;
+  out->union_mask = 0;
+}
+
+// capacity 0 asks for the totals only, so it never counts as truncated
+static int8_t _report_status(const EmergencyActiveReport_t* const restrict out)
+{
+  return out->capacity && out->count > out->capacity ? -1 : 0;
+}
+
+//public
+
+EmergencyScanKernel_t EmergencyScan_kernel(void)
+{
+  uint_fast8_t kernel = atomic_load_explicit(&SELECTED, memory_order_relaxed);
+  if (kernel == EMERGENCY_SCAN_AUTO)
+  {
+    // racing first scans all store the same kernel
+    kernel = _best();
+    atomic_store_explicit(&SELECTED, kernel, memory_order_relaxed);
+  }
+
+  return (EmergencyScanKernel_t) kernel;
+}
+
+int8_t EmergencyScan_select(const EmergencyScanKernel_t kernel)
+{
+  if (!_supported(kernel))
+  {
+    return -1;
+  }
+
+  atomic_store_explicit(&SELECTED, kernel, memory_order_relaxed);
+  return 0;
+}
+
+int8_t EmergencyNode_collect_active(const EmergencyNode_t* const restrict nodes, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out)
+{
+  _report_reset(out);
+  if (!n)
+  {
+    return 0;
+  }
+
+  if (SCAN_WORDS_PACKED)
+  {
+    _kernel_fn(EmergencyScan_kernel())((const uint64_t*) nodes->emergency_buffer, n, out);
+  }
+  else
+  {
+    _scan_strided((const uint8_t*) nodes, n, sizeof(EmergencyNode_t), out);
+  }
+
+  return _report_status(out);
+}
+
+int8_t EmergencyNode_array_collect_active(const EmergencyNodeArray_t* const restrict p_array,
+    EmergencyActiveReport_t* const restrict out)
+{
+  if (p_array->stride == sizeof(EmergencyNode_t))
+  {
+    return EmergencyNode_collect_active((const EmergencyNode_t*) p_array->nodes, p_array->count, out);
+  }
+
+  _report_reset(out);
+  _scan_strided(p_array->nodes, p_array->count, p_array->stride, out);
+
+  return _report_status(out);
+}
@@ -0,0 +1,59 @@
+#ifndef __EMERGENCY_SCAN__
+#define __EMERGENCY_SCAN__
+
+#include "./emergency_module.h"
+#include <stdint.h>
+
+/*
+ * Bulk scan of many plain nodes for the ones in emergency, for reports over
+ * thousands of nodes. The kernels OR blocks of node words with SSE2/AVX2 on
+ * x86 and NEON on aarch64 and only look at single nodes of blocks that are
+ * not all clear, so a mostly clear array is read at memory speed. The kernel
+ * is picked from the CPU on the first scan; without a vector unit, and for
+ * node layouts that are not one word per node (EMERGENCY_CONTEXTS, PADDED
+ * arrays), a scalar loop walks the nodes.
+ *
+ * Nodes are read with plain loads: the caller keeps writers away while it
+ * scans, as for any other read of an EmergencyNode_t.
+ */
+
+typedef enum {
+  EMERGENCY_SCAN_AUTO,
+  EMERGENCY_SCAN_SCALAR,
+  EMERGENCY_SCAN_SSE2,
+  EMERGENCY_SCAN_AVX2,
+  EMERGENCY_SCAN_NEON,
+}EmergencyScanKernel_t;
+
+typedef struct {
+  // caller storage for the indices of nodes in emergency, ascending
+  uint32_t* indices;
+  uint32_t capacity;
+  // nodes in emergency; only the first capacity of them have their index stored
+  uint32_t count;
+  // active exceptions over all nodes, counted once per node
+  uint32_t exceptions;
+  // exceptions active on any node
+  uint64_t union_mask;
+}EmergencyActiveReport_t;
+
+/*
+ * Fills out for nodes[0 .. n-1]; indices may be NULL with capacity 0 when
+ * only the totals are wanted, which returns 0. Otherwise -1 when more than
+ * capacity nodes are in emergency (count and the totals are still complete).
+ */
+int8_t EmergencyNode_collect_active(const EmergencyNode_t* const restrict nodes, const uint32_t n,
+    EmergencyActiveReport_t* const restrict out)__attribute__((__nonnull__(3)));
+
+int8_t EmergencyNode_array_collect_active(const EmergencyNodeArray_t* const restrict p_array,
+    EmergencyActiveReport_t* const restrict out)__attribute__((__nonnull__(1, 2)));
+
+/*
+ * Forces the kernel of later scans, for benchmarks and tests; AUTO goes back
+ * to the CPU's best. -1 when this CPU or build has no such kernel.
+ */
+int8_t EmergencyScan_select(const EmergencyScanKernel_t kernel);
+
+EmergencyScanKernel_t EmergencyScan_kernel(void);
+
+#endif // !__EMERGENCY_SCAN__
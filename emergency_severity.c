@@ -0,0 +1,129 @@
+#include "./emergency_severity.h"
+
+#ifdef EMERGENCY_SEVERITY
+
+#include "./emergency_internal.h"
+#include <stdatomic.h>
+
+//private
+
+/*
+ * The summary word is read every control cycle and only written when a
+ * class changes sign, so it gets a line of its own; so does every class
+ * counter, since unrelated classes are raised from different threads.
+ */
+static struct{
+  atomic_uint_fast64_t active __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  // exceptions of each class, read on every change
+  uint64_t mask[EMERGENCY_SEVERITY_CLASSES] __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  struct{
+    atomic_int_least32_t count;
+  } __attribute__((__aligned__(EMERGENCY_CACHE_LINE))) counter[EMERGENCY_SEVERITY_CLASSES];
+}SEVERITY;
+
+/*
+ * Brings the class bit in line with its counter. As with the LED, the
+ * crossing seen by the caller may be stale by the time the bit is written,
+ * so the counter is read again after every write.
+ */
+static void _sync_class(const uint8_t c)
+{
+  const uint_fast64_t bit = UINT64_C(1) << c;
+  uint8_t positive = atomic_load(&SEVERITY.counter[c].count) > 0;
+  for (;;)
+  {
+    if (positive)
+    {
+      atomic_fetch_or(&SEVERITY.active, bit);
+    }
+    else
+    {
+      atomic_fetch_and(&SEVERITY.active, ~bit);
+    }
+
+    const uint8_t now = atomic_load(&SEVERITY.counter[c].count) > 0;
+    if (now == positive)
+    {
+      break;
+    }
+    positive = now;
+  }
+}
+
+//internal
+
+void EmergencySeverity_change(const uint64_t bits, const int8_t direction)
+{
+  for (uint8_t c = 0; c < EMERGENCY_SEVERITY_CLASSES; c++)
+  {
+    const uint64_t hit = bits & SEVERITY.mask[c];
+    if (!hit)
+    {
+      continue;
+    }
+
+    const int32_t delta = direction * __builtin_popcountll(hit);
+    const int32_t old = atomic_fetch_add(&SEVERITY.counter[c].count, delta);
+    // only a crossing between <= 0 and > 0 changes the summary
+    if ((old > 0) != (old + delta > 0))
+    {
+      _sync_class(c);
+    }
+  }
+}
+
+//public
+
+int8_t EmergencySeverity_map(const uint8_t severity, const uint64_t exceptions)
+{
+  if (severity >= EMERGENCY_SEVERITY_CLASSES)
+  {
+    return -1;
+  }
+
+  for (uint8_t c = 0; c < EMERGENCY_SEVERITY_CLASSES; c++)
+  {
+    SEVERITY.mask[c] = c == severity ? SEVERITY.mask[c] | exceptions : SEVERITY.mask[c] & ~exceptions;
+  }
+
+  return 0;
+}
+
+int8_t EmergencySeverity_of(const uint8_t exception)
+{
+  if (exception >= 64)
+  {
+    return EMERGENCY_SEVERITY_NONE;
+  }
+
+  for (uint8_t c = 0; c < EMERGENCY_SEVERITY_CLASSES; c++)
+  {
+    if (SEVERITY.mask[c] & (UINT64_C(1) << exception))
+    {
+      return (int8_t) c;
+    }
+  }
+  return EMERGENCY_SEVERITY_NONE;
+}
+
+int8_t EmergencySeverity_highest(void)
+{
+  const uint64_t active = atomic_load_explicit(&SEVERITY.active, memory_order_acquire);
+  return active ? (int8_t) (63 - __builtin_clzll(active)) : EMERGENCY_SEVERITY_NONE;
+}
+
+uint64_t EmergencySeverity_active(void)
+{
+  return atomic_load_explicit(&SEVERITY.active, memory_order_acquire);
+}
+
+int32_t EmergencySeverity_count(const uint8_t severity)
+{
+  if (severity >= EMERGENCY_SEVERITY_CLASSES)
+  {
+    return 0;
+  }
+  return atomic_load(&SEVERITY.counter[severity].count);
+}
+
+#endif // EMERGENCY_SEVERITY
@@ -0,0 +1,59 @@
+#ifndef __EMERGENCY_SEVERITY__
+#define __EMERGENCY_SEVERITY__
+
+#include <stdint.h>
+
+/*
+ * Severity classes, compiled in with -DEMERGENCY_SEVERITY.
+ *
+ * Exceptions 0..63 are mapped to classes with EmergencySeverity_map; a
+ * higher class is more severe and an unmapped exception has no class. Every
+ * real bit change of an EmergencyNode_t or EmergencyNodeAtomic_t updates the
+ * count of active exceptions of its class, and a class that becomes active
+ * or clear sets or clears its bit in one summary word. The highest active
+ * severity across the system is then one load and a count-leading-zeros,
+ * without any lock.
+ *
+ * Build the mapping before exceptions are raised; remapping an active
+ * exception leaves its old class counted. Exceptions of the sized nodes
+ * (emergency_node_sized.h) are not classified, their hooks only report node
+ * edges.
+ */
+
+#ifdef EMERGENCY_SEVERITY
+
+#ifndef EMERGENCY_SEVERITY_CLASSES
+#define EMERGENCY_SEVERITY_CLASSES 3
+#endif
+
+#if EMERGENCY_SEVERITY_CLASSES > 64
+#error "EMERGENCY_SEVERITY_CLASSES must fit the 64-bit summary"
+#endif
+
+// the default classes; builds with more classes number the rest themselves
+typedef enum {
+  EMERGENCY_SEVERITY_WARNING,
+  EMERGENCY_SEVERITY_DERATE,
+  EMERGENCY_SEVERITY_SHUTDOWN,
+}EmergencySeverity_t;
+
+#define EMERGENCY_SEVERITY_NONE (-1)
+
+// moves every exception in exceptions to severity; -1 for an unknown class
+int8_t EmergencySeverity_map(const uint8_t severity, const uint64_t exceptions);
+
+// class of exception, EMERGENCY_SEVERITY_NONE when unmapped
+int8_t EmergencySeverity_of(const uint8_t exception);
+
+// highest class with an active exception anywhere, EMERGENCY_SEVERITY_NONE if none
+int8_t EmergencySeverity_highest(void);
+
+// bit c set while class c has active exceptions
+uint64_t EmergencySeverity_active(void);
+
+// active exceptions of severity, summed over all nodes
+int32_t EmergencySeverity_count(const uint8_t severity);
+
+#endif // EMERGENCY_SEVERITY
+
+#endif // !__EMERGENCY_SEVERITY__
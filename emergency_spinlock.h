@@ -0,0 +1,102 @@
+#ifndef __EMERGENCY_SPINLOCK__
+#define __EMERGENCY_SPINLOCK__
+
+#include <stdatomic.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+/*
+ * Test-and-test-and-set spinlock with bounded exponential backoff.
+ *
+ * Waiters spin on a plain load, so the line stays shared while the lock is
+ * held and only a free lock is attempted with an exchange. Every failed
+ * round waits 1, 2, 4 .. EMERGENCY_SPIN_BACKOFF_MAX relax hints (pause on
+ * x86, yield on AArch64). After EMERGENCY_SPIN_YIELD_AFTER rounds the waiter
+ * also gives its time slice to the OS, which matters when the holder was
+ * preempted on the same core; 0 never yields.
+ */
+
+#ifndef EMERGENCY_SPIN_BACKOFF_MAX
+#define EMERGENCY_SPIN_BACKOFF_MAX 64
+#endif
+
+#ifndef EMERGENCY_SPIN_YIELD_AFTER
+#define EMERGENCY_SPIN_YIELD_AFTER 16
+#endif
+
+typedef struct {
+  atomic_uint locked;
+}EmergencySpinlock_t;
+
+#define EMERGENCY_SPINLOCK_INIT {0}
+
+static inline void EmergencySpinlock_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield" ::: "memory");
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+static inline void EmergencySpinlock_yield(void)
+{
+#ifdef _WIN32
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+static inline void EmergencySpinlock_init(EmergencySpinlock_t* const restrict p_self)
+{
+  atomic_init(&p_self->locked, 0);
+}
+
+static inline uint8_t EmergencySpinlock_try_lock(EmergencySpinlock_t* const restrict p_self)
+{
+  return !atomic_load_explicit(&p_self->locked, memory_order_relaxed) &&
+    !atomic_exchange_explicit(&p_self->locked, 1, memory_order_acquire);
+}
+
+// returns the number of failed rounds before the lock was taken
+static inline uint32_t EmergencySpinlock_lock(EmergencySpinlock_t* const restrict p_self)
+{
+  uint32_t rounds = 0;
+  uint32_t backoff = 1;
+
+  while (!EmergencySpinlock_try_lock(p_self))
+  {
+    rounds++;
+    if (EMERGENCY_SPIN_YIELD_AFTER && rounds >= EMERGENCY_SPIN_YIELD_AFTER)
+    {
+      EmergencySpinlock_yield();
+    }
+    else
+    {
+      for (uint32_t i = 0; i < backoff; i++)
+      {
+        EmergencySpinlock_relax();
+      }
+      if (backoff < EMERGENCY_SPIN_BACKOFF_MAX)
+      {
+        backoff <<= 1;
+      }
+    }
+  }
+
+  return rounds;
+}
+
+static inline void EmergencySpinlock_unlock(EmergencySpinlock_t* const restrict p_self)
+{
+  atomic_store_explicit(&p_self->locked, 0, memory_order_release);
+}
+
+#endif // !__EMERGENCY_SPINLOCK__
@@ -1,9 +1,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <unistd.h>
+#ifdef EMERGENCY_EXPORT
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 #include "emergency_module.h"
+#include "emergency_node_sized.h"
+#include "emergency_registry.h"
+#include "emergency_trace.h"
+#include "emergency_events.h"
+#include "emergency_export.h"
+#include "emergency_notify.h"
+#include "emergency_context.h"
+#include "emergency_severity.h"
+#include "emergency_scan.h"
+#include "emergency_pool.h"
+#include "emergency_timing.h"
+#include "emergency_debounce.h"
+#include "emergency_replay.h"
+
+EMERGENCY_NODE_DEFINE(SmallNode, 4, uint8_t)
+EMERGENCY_NODE_DEFINE(LargeNode, 300, uint64_t)
 
 // Test statistics
 static int tests_passed = 0;
@@ -46,9 +68,14 @@ void test_node_init_right() {
     
     int8_t result = EmergencyNode_init(&node);
     TEST_ASSERT(result == 0, "Init should return 0");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should be zeroed");
-    
-    for (int i = 0; i < NUM_EMERGENCY_BUFFER; i++) {
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should be zeroed");
+#ifndef EMERGENCY_CONTEXTS
+    TEST_ASSERT(sizeof(EmergencyNode_t) == sizeof(uint64_t), "Node should be a single word");
+#else
+    TEST_ASSERT(sizeof(EmergencyNode_t) == sizeof(uint64_t) + sizeof(void*), "Node should be a word and its context");
+#endif
+    
+    for (int i = 0; i < NUM_EMERGENCY_WORDS; i++) {
         TEST_ASSERT(node.emergency_buffer[i] == 0, "Buffer should be zeroed");
     }
     
@@ -64,18 +91,20 @@ void test_raise_emergency_right() {
     // Raise emergency 5
     int8_t result = EmergencyNode_raise(&node, 5);
     TEST_ASSERT(result == 0, "Raise should succeed");
-    TEST_ASSERT(node.emergency_counter == 1, "Counter should be 1");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Counter should be 1");
     TEST_ASSERT((node.emergency_buffer[0] & (1 << 5)) != 0, "Bit 5 should be set");
     
     // Raise same emergency again
     result = EmergencyNode_raise(&node, 5);
     TEST_ASSERT(result == 0, "Raise should succeed");
-    TEST_ASSERT(node.emergency_counter == 1, "Counter should still be 1");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Counter should still be 1");
     
     // Raise different emergency
     result = EmergencyNode_raise(&node, 10);
     TEST_ASSERT(result == 0, "Raise should succeed");
-    TEST_ASSERT(node.emergency_counter == 2, "Counter should be 2");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 2, "Counter should be 2");
+
+    EmergencyNode_destroy(&node);
     
     TEST_PASS("Emergency raise");
 }
@@ -88,20 +117,92 @@ void test_solve_emergency_right() {
     
     EmergencyNode_raise(&node, 5);
     EmergencyNode_raise(&node, 10);
-    TEST_ASSERT(node.emergency_counter == 2, "Counter should be 2");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 2, "Counter should be 2");
     
     int8_t result = EmergencyNode_solve(&node, 5);
     TEST_ASSERT(result == 0, "Solve should succeed");
-    TEST_ASSERT(node.emergency_counter == 1, "Counter should be 1");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Counter should be 1");
     TEST_ASSERT((node.emergency_buffer[0] & (1 << 5)) == 0, "Bit 5 should be cleared");
     
     result = EmergencyNode_solve(&node, 10);
     TEST_ASSERT(result == 0, "Solve should succeed");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should be 0");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should be 0");
     
     TEST_PASS("Emergency solve");
 }
 
+void test_mask_raise_solve_right() {
+    printf("\n[RIGHT] Testing EmergencyNode_raise_mask/solve_mask...\n");
+    
+    EmergencyNode_t node;
+    EmergencyNode_t probe;
+    EmergencyNode_init(&node);
+    EmergencyNode_init(&probe);
+    
+    const uint64_t mask = (UINT64_C(1) << 3) | (UINT64_C(1) << 17) | (UINT64_C(1) << 63);
+    int8_t result = EmergencyNode_raise_mask(&node, mask);
+    TEST_ASSERT(result == 0, "Mask raise should succeed");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 3, "Counter should be the popcount of the mask");
+    TEST_ASSERT(node.emergency_buffer[0] == mask, "Every bit of the mask should be set");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "Global state should see the mask raise");
+    
+    // Overlapping mask: only bit 4 is new
+    EmergencyNode_raise_mask(&node, (UINT64_C(1) << 3) | (UINT64_C(1) << 4));
+    TEST_ASSERT(EmergencyNode_counter(&node) == 4, "Only new bits should be counted");
+    
+    result = EmergencyNode_solve_mask(&node, (UINT64_C(1) << 3) | (UINT64_C(1) << 5));
+    TEST_ASSERT(result == 0, "Mask solve should succeed");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 3, "Only active bits should be solved");
+    
+    EmergencyNode_solve_mask(&node, UINT64_MAX);
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Full mask should solve everything");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Global state should be released");
+    
+    EmergencyNodeAtomic_t shared;
+    EmergencyNodeAtomic_init(&shared);
+    EmergencyNodeAtomic_raise_mask(&shared, mask);
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&shared) == 3, "Atomic mask raise should set every bit");
+    EmergencyNodeAtomic_solve_mask(&shared, mask);
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&shared) == 0, "Atomic mask solve should clear every bit");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Atomic mask solve should release the global state");
+    
+    TEST_PASS("Mask raise/solve");
+}
+
+void test_sized_nodes_right() {
+    printf("\n[RIGHT] Testing compile-time sized node types...\n");
+    
+    SmallNode_t small;
+    LargeNode_t large;
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    
+    TEST_ASSERT(sizeof(SmallNode_t) == 1, "A 4-exception node should fit in one byte");
+    TEST_ASSERT(sizeof(LargeNode_t) == 5 * sizeof(uint64_t), "A 300-exception node should use 5 words");
+    
+    SmallNode_init(&small);
+    TEST_ASSERT(SmallNode_raise(&small, 3) == 0, "Last small id should succeed");
+    TEST_ASSERT(SmallNode_raise(&small, 4) == -1, "Small id 4 should be out of bounds");
+    TEST_ASSERT(SmallNode_counter(&small) == 1, "Small counter should be 1");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "Small node should reach the global state");
+    
+    LargeNode_init(&large);
+    TEST_ASSERT(LargeNode_raise(&large, 299) == 0, "Ids past 255 should succeed");
+    TEST_ASSERT(LargeNode_raise(&large, 300) == -1, "Large id 300 should be out of bounds");
+    LargeNode_raise(&large, 64);
+    LargeNode_raise(&large, 64);
+    TEST_ASSERT(LargeNode_counter(&large) == 2, "Large counter should be 2");
+    
+    SmallNode_solve(&small, 3);
+    TEST_ASSERT(LargeNode_is_emergency_state(&large) != 0, "Large node should still be in emergency");
+    LargeNode_solve(&large, 299);
+    LargeNode_destroy(&large);
+    TEST_ASSERT(LargeNode_counter(&large) == 0, "Destroy should clear the large node");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Global state should be released");
+    
+    TEST_PASS("Sized node types");
+}
+
 // ====================
 // INVERSE RELATIONSHIP TESTS
 // ====================
@@ -116,12 +217,12 @@ void test_raise_solve_inverse() {
     for (uint8_t i = 0; i < 20; i++) {
         EmergencyNode_raise(&node, i);
     }
-    TEST_ASSERT(node.emergency_counter == 20, "Counter should be 20");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 20, "Counter should be 20");
     
     for (uint8_t i = 0; i < 20; i++) {
         EmergencyNode_solve(&node, i);
     }
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should return to 0");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should return to 0");
     
     TEST_PASS("Raise/solve inverse relationship");
 }
@@ -137,19 +238,78 @@ void test_emergency_state_cross_check() {
     EmergencyNode_init(&node);
 
     // Verify that node counter is 0
-    TEST_ASSERT(node.emergency_counter == 0, "Node counter should be 0 initially");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Node counter should be 0 initially");
 
     EmergencyNode_raise(&node, 7);
     int8_t state = EmergencyNode_is_emergency_state(&node);
     TEST_ASSERT(state != 0, "Should be in emergency state after raise");
-    TEST_ASSERT(node.emergency_counter == 1, "Node counter should be 1 after raise");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Node counter should be 1 after raise");
 
     EmergencyNode_solve(&node, 7);
-    TEST_ASSERT(node.emergency_counter == 0, "Node counter should be 0 after solve");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Node counter should be 0 after solve");
 
     TEST_PASS("Emergency state cross-check");
 }
 
+void test_registry_cross_check() {
+    printf("\n[CROSS-CHECK] Testing node registry summary...\n");
+    
+    EmergencyNodeAtomic_t* a = EmergencyRegistry_acquire();
+    EmergencyNodeAtomic_t* b = EmergencyRegistry_acquire();
+    EmergencyNodeAtomic_t* c = EmergencyRegistry_acquire();
+    EmergencyNodeAtomic_t outsider;
+    EmergencyNodeAtomic_init(&outsider);
+    
+    TEST_ASSERT(a && b && c, "Acquire should hand out registry nodes");
+    TEST_ASSERT(EmergencyRegistry_index(&outsider) == -1, "A foreign node should not be registered");
+    TEST_ASSERT(EmergencyRegistry_node(EmergencyRegistry_index(b)) == b, "Index and node should round-trip");
+    TEST_ASSERT(!EmergencyRegistry_any_emergency(), "No registered node should be in emergency");
+    
+    EmergencyNodeAtomic_raise(b, 2);
+    EmergencyNodeAtomic_raise(c, 40);
+    EmergencyNodeAtomic_raise(c, 41);
+    const int16_t ib = EmergencyRegistry_index(b);
+    const int16_t ic = EmergencyRegistry_index(c);
+    TEST_ASSERT(EmergencyRegistry_any_emergency(), "Summary should report an emergency");
+    TEST_ASSERT(EmergencyRegistry_next_emergency(0) == ib, "First node in emergency should be b");
+    TEST_ASSERT(EmergencyRegistry_next_emergency(ib + 1) == ic, "Next node in emergency should be c");
+    TEST_ASSERT(EmergencyRegistry_next_emergency(ic + 1) == -1, "No node should follow c");
+    
+    EmergencyNodeAtomic_raise(&outsider, 1);
+    EmergencyNodeAtomic_solve(b, 2);
+    EmergencyNodeAtomic_solve(c, 40);
+    TEST_ASSERT(EmergencyRegistry_next_emergency(0) == ic, "c should still be in emergency");
+    EmergencyNodeAtomic_solve_mask(c, UINT64_MAX);
+    TEST_ASSERT(!EmergencyRegistry_any_emergency(), "Outsider nodes should not reach the summary");
+    EmergencyNodeAtomic_destroy(&outsider);
+    
+    EmergencyNodeAtomic_raise(a, 7);
+    TEST_ASSERT(EmergencyRegistry_release(a) == 0, "Release should succeed");
+    TEST_ASSERT(EmergencyRegistry_release(a) == -1, "Double release should fail");
+    TEST_ASSERT(!EmergencyRegistry_any_emergency(), "Release should clear the node from the summary");
+    EmergencyRegistry_release(b);
+    EmergencyRegistry_release(c);
+    
+    EmergencyNodeAtomic_t* nodes[EMERGENCY_REGISTRY_CAPACITY];
+    for (int i = 0; i < EMERGENCY_REGISTRY_CAPACITY; i++) {
+        nodes[i] = EmergencyRegistry_acquire();
+    }
+    TEST_ASSERT(nodes[EMERGENCY_REGISTRY_CAPACITY - 1] != NULL, "The whole capacity should be available");
+    TEST_ASSERT(EmergencyRegistry_acquire() == NULL, "Acquire past capacity should fail");
+    EmergencyNodeAtomic_raise(nodes[EMERGENCY_REGISTRY_CAPACITY - 1], 0);
+    TEST_ASSERT(EmergencyRegistry_next_emergency(0) == EMERGENCY_REGISTRY_CAPACITY - 1, "The last node should be found");
+    for (int i = 0; i < EMERGENCY_REGISTRY_CAPACITY; i++) {
+        EmergencyRegistry_release(nodes[i]);
+    }
+    TEST_ASSERT(!EmergencyRegistry_any_emergency(), "Registry should be clear");
+    
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Global state should be released");
+    
+    TEST_PASS("Node registry summary");
+}
+
 // ====================
 // ERROR CONDITION TESTS
 // ====================
@@ -170,6 +330,8 @@ void test_boundary_conditions_error() {
     
     result = EmergencyNode_solve(&node, 64);
     TEST_ASSERT(result == -1, "Solve ID 64 should fail");
+
+    EmergencyNode_destroy(&node);
     
     TEST_PASS("Boundary condition handling");
 }
@@ -183,7 +345,7 @@ void test_solve_nonexistent_error() {
     // Solving emergency that was never raised should be safe
     int8_t result = EmergencyNode_solve(&node, 5);
     TEST_ASSERT(result == 0, "Solving non-existent should succeed gracefully");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should remain 0");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should remain 0");
     
     TEST_PASS("Solve non-existent emergency");
 }
@@ -196,11 +358,11 @@ void test_destroy_with_active_emergencies() {
     
     EmergencyNode_raise(&node, 5);
     EmergencyNode_raise(&node, 10);
-    TEST_ASSERT(node.emergency_counter == 2, "Counter should be 2");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 2, "Counter should be 2");
     
     int8_t result = EmergencyNode_destroy(&node);
     TEST_ASSERT(result == 0, "Destroy should succeed");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should be cleared");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should be cleared");
     
     TEST_PASS("Destroy with active emergencies");
 }
@@ -226,7 +388,7 @@ void test_performance_many_operations() {
         EmergencyNode_solve(&node, id);
     }
     
-    TEST_ASSERT(node.emergency_counter == 0, "All emergencies should be solved");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "All emergencies should be solved");
     
     TEST_PASS("Performance with many operations");
 }
@@ -236,7 +398,7 @@ void test_performance_many_operations() {
 // ====================
 
 typedef struct {
-    EmergencyNode_t* node;
+    EmergencyNodeAtomic_t* node;
     int thread_id;
     int iterations;
 } ThreadTestData;
@@ -246,7 +408,7 @@ void* thread_raise_worker(void* arg) {
     
     for (int i = 0; i < data->iterations; i++) {
         uint8_t emergency_id = (data->thread_id * 8 + (i % 8)) % 64;
-        EmergencyNode_raise(data->node, emergency_id);
+        EmergencyNodeAtomic_raise(data->node, emergency_id);
         usleep(10); // Small delay to increase contention
     }
     
@@ -258,18 +420,66 @@ void* thread_solve_worker(void* arg) {
     
     for (int i = 0; i < data->iterations; i++) {
         uint8_t emergency_id = (data->thread_id * 8 + (i % 8)) % 64;
-        EmergencyNode_solve(data->node, emergency_id);
+        EmergencyNodeAtomic_solve(data->node, emergency_id);
         usleep(10);
     }
     
     return NULL;
 }
 
+void* thread_global_toggle_worker(void* arg) {
+    ThreadTestData* data = (ThreadTestData*)arg;
+    
+    // Every iteration is a 0->1 and 1->0 edge of this thread's own node,
+    // so all the contention lands on the global counter.
+    for (int i = 0; i < data->iterations; i++) {
+        EmergencyNodeAtomic_raise(data->node, data->thread_id);
+        EmergencyNodeAtomic_solve(data->node, data->thread_id);
+    }
+    
+    return NULL;
+}
+
+void test_multithreaded_global_counter() {
+    printf("\n[MULTITHREADED] Testing global counter with per-thread nodes...\n");
+    
+    const int NUM_THREADS = 10;
+    const int ITERATIONS = 10000;
+    pthread_t threads[NUM_THREADS];
+    ThreadTestData thread_data[NUM_THREADS];
+    EmergencyNodeAtomic_t nodes[NUM_THREADS];
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "No emergency should be active before the run");
+    
+    for (int i = 0; i < NUM_THREADS; i++) {
+        EmergencyNodeAtomic_init(&nodes[i]);
+        thread_data[i].node = &nodes[i];
+        thread_data[i].thread_id = i;
+        thread_data[i].iterations = ITERATIONS;
+        pthread_create(&threads[i], NULL, thread_global_toggle_worker, &thread_data[i]);
+    }
+    
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Global counter should return to 0");
+    
+    EmergencyNodeAtomic_raise(&nodes[0], 1);
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "Global counter should see the raise");
+    EmergencyNodeAtomic_solve(&nodes[0], 1);
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Global counter should see the solve");
+    
+    TEST_PASS("Multithreaded global counter");
+}
+
 void test_multithreaded_raise() {
     printf("\n[MULTITHREADED] Testing concurrent raise operations...\n");
     
-    EmergencyNode_t node;
-    EmergencyNode_init(&node);
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
     
     const int NUM_THREADS = 4;
     const int ITERATIONS = 100;
@@ -287,17 +497,20 @@ void test_multithreaded_raise() {
         pthread_join(threads[i], NULL);
     }
     
-    TEST_ASSERT(node.emergency_counter > 0, "Some emergencies should be raised");
-    TEST_ASSERT(node.emergency_counter <= 64, "Counter should not exceed max emergencies");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) == 32, "Every raised emergency should be counted");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) <= 64, "Counter should not exceed max emergencies");
     
+    EmergencyNodeAtomic_destroy(&node);
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 0, "Destroy should release the global counter");
+
     TEST_PASS("Multithreaded raise operations");
 }
 
 void test_multithreaded_raise_and_solve() {
     printf("\n[MULTITHREADED] Testing concurrent raise and solve...\n");
     
-    EmergencyNode_t node;
-    EmergencyNode_init(&node);
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
     
     const int NUM_THREADS = 8;
     const int ITERATIONS = 50;
@@ -322,8 +535,11 @@ void test_multithreaded_raise_and_solve() {
     }
     
     // System should remain consistent
-    TEST_ASSERT(node.emergency_counter <= 64, "Counter should be valid");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) <= 64, "Counter should be valid");
     
+    EmergencyNodeAtomic_destroy(&node);
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 0, "Destroy should release the global counter");
+
     TEST_PASS("Multithreaded raise and solve");
 }
 
@@ -334,9 +550,9 @@ void* thread_stress_worker(void* arg) {
         uint8_t emergency_id = rand() % 64;
         
         if (rand() % 2) {
-            EmergencyNode_raise(data->node, emergency_id);
+            EmergencyNodeAtomic_raise(data->node, emergency_id);
         } else {
-            EmergencyNode_solve(data->node, emergency_id);
+            EmergencyNodeAtomic_solve(data->node, emergency_id);
         }
     }
     
@@ -346,8 +562,8 @@ void* thread_stress_worker(void* arg) {
 void test_multithreaded_stress() {
     printf("\n[MULTITHREADED] Stress testing with random operations...\n");
     
-    EmergencyNode_t node;
-    EmergencyNode_init(&node);
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
     
     const int NUM_THREADS = 10;
     const int ITERATIONS = 1000;
@@ -365,8 +581,11 @@ void test_multithreaded_stress() {
         pthread_join(threads[i], NULL);
     }
     
-    TEST_ASSERT(node.emergency_counter <= 64, "Counter should remain valid after stress");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) <= 64, "Counter should remain valid after stress");
     
+    EmergencyNodeAtomic_destroy(&node);
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 0, "Destroy should release the global counter");
+
     TEST_PASS("Multithreaded stress test");
 }
 
@@ -374,6 +593,240 @@ void test_multithreaded_stress() {
 // ADDITIONAL EDGE CASES
 // ====================
 
+void test_multithreaded_system_snapshot() {
+    printf("\n[MULTITHREADED] Testing system snapshots against concurrent writers...\n");
+    
+    const int NUM_THREADS = 4;
+    const int ITERATIONS = 20000;
+    const int SNAPSHOTS = 2000;
+    pthread_t threads[NUM_THREADS];
+    ThreadTestData thread_data[NUM_THREADS];
+    int16_t index[NUM_THREADS];
+    static EmergencySystemSnapshot_t snapshot;
+    int consistent = 0;
+    int taken = 0;
+    int failed = 0;
+    
+    TEST_ASSERT(EmergencySystem_snapshot(&snapshot) == 0, "Snapshot should succeed without writers");
+    const int32_t base = snapshot.global_counter;
+    
+    for (int i = 0; i < NUM_THREADS; i++) {
+        thread_data[i].node = EmergencyRegistry_acquire();
+        TEST_ASSERT(thread_data[i].node != NULL, "Registry node should be acquired");
+        index[i] = EmergencyRegistry_index(thread_data[i].node);
+        thread_data[i].thread_id = i;
+        thread_data[i].iterations = ITERATIONS;
+        pthread_create(&threads[i], NULL, thread_global_toggle_worker, &thread_data[i]);
+    }
+    
+    // every node edge moves the counter inside the same window as the node bits
+    for (int s = 0; s < SNAPSHOTS; s++) {
+        const int8_t status = EmergencySystem_snapshot(&snapshot);
+        if (status) {
+            failed += status != -1;
+            // on one CPU the conflict may be a writer preempted inside its window
+            sched_yield();
+            continue;
+        }
+        taken++;
+        int32_t active = 0;
+        for (int i = 0; i < NUM_THREADS; i++) {
+            active += snapshot.nodes[index[i]] != 0;
+        }
+        consistent += snapshot.global_counter == base + active;
+    }
+    
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        EmergencyRegistry_release(thread_data[i].node);
+    }
+    
+    TEST_ASSERT(failed == 0, "Conflicting snapshots should only ever fail with -1");
+    TEST_ASSERT(taken > 0, "Some snapshots should succeed under contention");
+    TEST_ASSERT(consistent == taken, "Every snapshot should match nodes and counter");
+    TEST_ASSERT(EmergencySystem_snapshot(&snapshot) == 0 && snapshot.global_counter == base, "Counter should return to its start value");
+    
+    TEST_PASS("System snapshots against concurrent writers");
+}
+
+// deferred LED builds only show an edge after the next flush
+static void settle_led(void) {
+#ifdef EMERGENCY_DEFERRED_LED
+    usleep(EMERGENCY_LED_PERIOD_NS / 1000 + 1);
+    EmergencyNode_led_flush();
+#endif
+}
+
+typedef struct {
+    int calls;
+    const void* node;
+    uint8_t state;
+} NotifyRecord;
+
+static void record_notify(void* ctx, const void* p_node, uint8_t state) {
+    NotifyRecord* record = ctx;
+    record->calls++;
+    record->node = p_node;
+    record->state = state;
+}
+
+void test_change_notification() {
+    printf("\n[NOTIFY] Testing change-notification callbacks...\n");
+    
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_t other;
+    EmergencyNodeAtomic_init(&node);
+    EmergencyNodeAtomic_init(&other);
+    NotifyRecord led = {0};
+    NotifyRecord edge = {0};
+    
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 0, "Global state should start clear");
+    const int8_t led_id = EmergencyNotify_subscribe(NULL, record_notify, &led);
+    const int8_t edge_id = EmergencyNotify_subscribe(&node, record_notify, &edge);
+    TEST_ASSERT(led_id >= 0 && edge_id >= 0 && led_id != edge_id, "Subscriptions should get distinct ids");
+    
+    EmergencyNodeAtomic_raise(&node, 3);
+    settle_led();
+    TEST_ASSERT(led.calls == 1 && led.node == NULL && led.state == 1, "LED subscriber should see the flip on");
+    TEST_ASSERT(edge.calls == 1 && edge.node == &node && edge.state == 1, "Node subscriber should see the edge up");
+    
+    EmergencyNodeAtomic_raise(&node, 5);
+    // other has edges of its own, but nobody subscribed to them
+    const uint32_t epoch = EmergencyNotify_epoch();
+    EmergencyNodeAtomic_raise(&other, 1);
+    TEST_ASSERT(led.calls == 1 && edge.calls == 1, "Raises without a flip should not notify");
+    
+    EmergencyNodeAtomic_solve(&other, 1);
+    TEST_ASSERT(EmergencyNotify_epoch() == epoch, "Edges of an unsubscribed node should leave the epoch unchanged");
+    EmergencyNodeAtomic_solve(&node, 3);
+    settle_led();
+    TEST_ASSERT(led.calls == 1 && edge.calls == 1, "Solves without a flip should not notify");
+    
+    EmergencyNodeAtomic_solve(&node, 5);
+    settle_led();
+    TEST_ASSERT(led.calls == 2 && led.state == 0, "LED subscriber should see the flip off");
+    TEST_ASSERT(edge.calls == 2 && edge.state == 0, "Node subscriber should see the edge down");
+    
+    TEST_ASSERT(EmergencyNotify_unsubscribe(edge_id) == 0, "Unsubscribe should succeed");
+    TEST_ASSERT(EmergencyNotify_unsubscribe(edge_id) == -1, "Second unsubscribe should fail");
+    EmergencyNodeAtomic_raise_mask(&node, 0x3);
+    settle_led();
+    EmergencyNodeAtomic_destroy(&node);
+    settle_led();
+    TEST_ASSERT(edge.calls == 2, "Unsubscribed callback should not run");
+    TEST_ASSERT(led.calls == 4 && led.state == 0, "Mask raise and destroy should flip the LED");
+    
+    TEST_ASSERT(EmergencyNotify_unsubscribe(led_id) == 0, "Unsubscribe should succeed");
+    TEST_ASSERT(EmergencyNotify_unsubscribe(-1) == -1, "Invalid id should be rejected");
+    
+    int8_t ids[EMERGENCY_NOTIFY_SUBSCRIBERS];
+    for (int i = 0; i < EMERGENCY_NOTIFY_SUBSCRIBERS; i++) {
+        ids[i] = EmergencyNotify_subscribe(NULL, NULL, NULL);
+        TEST_ASSERT(ids[i] >= 0, "Every slot should be available");
+    }
+    TEST_ASSERT(EmergencyNotify_subscribe(NULL, NULL, NULL) == -1, "Subscribe should fail when full");
+    for (int i = 0; i < EMERGENCY_NOTIFY_SUBSCRIBERS; i++) {
+        EmergencyNotify_unsubscribe(ids[i]);
+    }
+    
+    TEST_PASS("Change-notification callbacks");
+}
+
+static void* notify_raise_worker(void* arg) {
+    usleep(20000);
+    EmergencyNodeAtomic_raise(arg, 0);
+    settle_led();
+    return NULL;
+}
+
+void test_multithreaded_notify_wait() {
+    printf("\n[MULTITHREADED] Testing sleeping until the LED flips...\n");
+    
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
+    pthread_t thread;
+    
+    const int8_t id = EmergencyNotify_subscribe(NULL, NULL, NULL);
+    TEST_ASSERT(id >= 0, "Waiter should subscribe to the LED");
+    
+    uint32_t epoch = EmergencyNotify_epoch();
+    TEST_ASSERT(EmergencyNotify_wait(epoch, 10) == -1, "Wait without a flip should time out");
+    
+    pthread_create(&thread, NULL, notify_raise_worker, &node);
+    int8_t woke = EmergencyNotify_wait(epoch, 5000);
+    pthread_join(thread, NULL);
+    TEST_ASSERT(woke == 0, "Raise on another thread should wake the waiter");
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 1, "Woken waiter should see the emergency");
+    
+    epoch = EmergencyNotify_epoch();
+    EmergencyNodeAtomic_solve(&node, 0);
+    settle_led();
+    TEST_ASSERT(EmergencyNotify_wait(epoch, 10) == 0, "A flip already past should not wait");
+    
+    EmergencyNotify_unsubscribe(id);
+    epoch = EmergencyNotify_epoch();
+    EmergencyNodeAtomic_raise(&node, 0);
+    settle_led();
+    EmergencyNodeAtomic_destroy(&node);
+    settle_led();
+    TEST_ASSERT(EmergencyNotify_epoch() == epoch, "Unsubscribed flips should not advance the epoch");
+    
+    TEST_PASS("Sleeping until the LED flips");
+}
+
+#define NOTIFY_RACE_ROUNDS 500
+
+typedef struct {
+    EmergencyNodeAtomic_t node;
+    atomic_uint round;
+    atomic_uint flipped;
+} NotifyRace;
+
+static void* notify_flip_worker(void* arg) {
+    NotifyRace* race = arg;
+    for (unsigned r = 1; r <= NOTIFY_RACE_ROUNDS; r++) {
+        while (atomic_load(&race->round) != r) {
+            sched_yield();
+        }
+        EmergencyNodeAtomic_raise(&race->node, 0);
+        atomic_store(&race->flipped, r);
+    }
+    return NULL;
+}
+
+void test_multithreaded_notify_subscribe_race() {
+    printf("\n[MULTITHREADED] Testing subscribe racing a node edge...\n");
+    
+    NotifyRace race;
+    EmergencyNodeAtomic_init(&race.node);
+    atomic_init(&race.round, 0);
+    atomic_init(&race.flipped, 0);
+    pthread_t thread;
+    pthread_create(&thread, NULL, notify_flip_worker, &race);
+    
+    // the edge lands anywhere around subscribe; a consumer that saw no
+    // emergency after subscribing must be woken by it
+    int lost = 0;
+    for (unsigned r = 1; r <= NOTIFY_RACE_ROUNDS; r++) {
+        atomic_store(&race.round, r);
+        const int8_t id = EmergencyNotify_subscribe(&race.node, NULL, NULL);
+        const uint32_t epoch = EmergencyNotify_epoch();
+        if (!EmergencyNodeAtomic_counter(&race.node) && EmergencyNotify_wait(epoch, 1000)) {
+            lost++;
+        }
+        EmergencyNotify_unsubscribe(id);
+        while (atomic_load(&race.flipped) != r) {
+            sched_yield();
+        }
+        EmergencyNodeAtomic_solve(&race.node, 0);
+    }
+    pthread_join(thread, NULL);
+    settle_led();
+    TEST_ASSERT(lost == 0, "No edge racing subscribe should be missed");
+    
+    TEST_PASS("Subscribe racing a node edge");
+}
+
 void test_all_emergencies_simultaneously() {
     printf("\n[EDGE CASE] Testing all 64 emergencies simultaneously...\n");
     
@@ -385,10 +838,10 @@ void test_all_emergencies_simultaneously() {
         EmergencyNode_raise(&node, i);
     }
     
-    TEST_ASSERT(node.emergency_counter == 64, "All 64 emergencies should be active");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 64, "All 64 emergencies should be active");
     
-    for (int i = 0; i < NUM_EMERGENCY_BUFFER; i++) {
-        TEST_ASSERT(node.emergency_buffer[i] == 0xFF, "All bits in buffer should be set");
+    for (int i = 0; i < NUM_EMERGENCY_WORDS; i++) {
+        TEST_ASSERT(node.emergency_buffer[i] == UINT64_MAX, "All bits in buffer should be set");
     }
     
     // Solve all
@@ -396,7 +849,7 @@ void test_all_emergencies_simultaneously() {
         EmergencyNode_solve(&node, i);
     }
     
-    TEST_ASSERT(node.emergency_counter == 0, "All emergencies should be solved");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "All emergencies should be solved");
     
     TEST_PASS("All emergencies simultaneously");
 }
@@ -413,17 +866,1116 @@ void test_byte_boundary_emergencies() {
         EmergencyNode_raise(&node, boundaries[i]);
     }
     
-    TEST_ASSERT(node.emergency_counter == sizeof(boundaries), "All boundary emergencies should be raised");
+    TEST_ASSERT(EmergencyNode_counter(&node) == sizeof(boundaries), "All boundary emergencies should be raised");
     
     for (int i = 0; i < sizeof(boundaries); i++) {
         EmergencyNode_solve(&node, boundaries[i]);
     }
     
-    TEST_ASSERT(node.emergency_counter == 0, "All boundary emergencies should be solved");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "All boundary emergencies should be solved");
     
     TEST_PASS("Byte boundary emergencies");
 }
 
+void test_node_array_layouts() {
+    printf("\n[EDGE CASE] Testing packed and padded node arrays...\n");
+    
+    EmergencyNodeArray_t packed;
+    EmergencyNodeArray_t padded;
+    EmergencyNodeArray_t empty;
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    
+    TEST_ASSERT(EmergencyNode_array_create(&packed, 100, EMERGENCY_LAYOUT_PACKED) == 0, "Packed array should be created");
+    TEST_ASSERT(EmergencyNode_array_create(&padded, 100, EMERGENCY_LAYOUT_PADDED) == 0, "Padded array should be created");
+    TEST_ASSERT(EmergencyNode_array_create(&empty, 0, EMERGENCY_LAYOUT_PACKED) == -1, "Empty array should fail");
+    
+    TEST_ASSERT((char*)EmergencyNode_array_at(&packed, 1) - (char*)EmergencyNode_array_at(&packed, 0) == sizeof(EmergencyNode_t), "Packed nodes should be contiguous");
+    for (uint32_t i = 0; i < padded.count; i++) {
+        TEST_ASSERT((uintptr_t)EmergencyNode_array_at(&padded, i) % EMERGENCY_CACHE_LINE == 0, "Padded nodes should start a cache line");
+        TEST_ASSERT(EmergencyNode_counter(EmergencyNode_array_at(&padded, i)) == 0, "Array nodes should start clear");
+    }
+    
+    EmergencyNode_raise(EmergencyNode_array_at(&packed, 99), 1);
+    EmergencyNode_raise(EmergencyNode_array_at(&padded, 42), 2);
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "Array nodes should reach the global state");
+    
+    EmergencyNode_array_destroy(&packed);
+    EmergencyNode_array_destroy(&padded);
+    TEST_ASSERT(packed.nodes == NULL && padded.count == 0, "Destroy should reset the array");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Destroy should release the global state");
+    
+    TEST_PASS("Packed and padded node arrays");
+}
+
+void test_many_nodes_global_counter() {
+    printf("\n[EDGE CASE] Testing global counter with 10000 nodes in emergency...\n");
+    
+    const int NUM_NODES = 10000;
+    EmergencyNode_t* nodes = malloc(NUM_NODES * sizeof(*nodes));
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    TEST_ASSERT(nodes != NULL, "Node array allocation should succeed");
+    
+    const int32_t base = EmergencyNode_global_counter();
+    for (int i = 0; i < NUM_NODES; i++) {
+        EmergencyNode_init(&nodes[i]);
+        EmergencyNode_raise(&nodes[i], i % 64);
+        if (base + i + 1 == 256) {
+            TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "256 nodes in emergency must not wrap to 0");
+        }
+    }
+    TEST_ASSERT(EmergencyNode_global_counter() == base + NUM_NODES, "Every node should be counted");
+    
+    for (int i = 0; i < NUM_NODES - 1; i++) {
+        EmergencyNode_destroy(&nodes[i]);
+    }
+    TEST_ASSERT(EmergencyNode_global_counter() == base + 1, "One node should remain counted");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "The last node should keep the emergency");
+    
+    EmergencyNode_solve(&nodes[NUM_NODES - 1], (NUM_NODES - 1) % 64);
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Counter should return to its start value");
+    free(nodes);
+    
+    TEST_PASS("Global counter with many nodes");
+}
+
+void test_node_pool() {
+    printf("\n[RIGHT] Testing the node pool...\n");
+
+    EmergencyNodePool_t pool;
+    EmergencyNodePool_t invalid;
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    static uint8_t seen[100];
+    memset(seen, 0, sizeof(seen));
+
+    TEST_ASSERT(EmergencyNodePool_create(&invalid, 0) == -1, "Empty pool should fail");
+    TEST_ASSERT(EmergencyNodePool_create(&pool, 100) == 0, "Pool should be created");
+    TEST_ASSERT((uintptr_t)pool.nodes % EMERGENCY_CACHE_LINE == 0, "Pool nodes should start a cache line");
+
+    for (int i = 0; i < 100; i++) {
+        const int32_t handle = EmergencyNodePool_acquire(&pool);
+        TEST_ASSERT(handle >= 0 && handle < 100 && !seen[handle], "Every handle should be handed out once");
+        seen[handle] = 1;
+    }
+    TEST_ASSERT(EmergencyNodePool_acquire(&pool) == -1, "Exhausted pool should fail");
+
+    EmergencyNode_raise(EmergencyNodePool_node(&pool, 17), 3);
+    EmergencyNode_raise(EmergencyNodePool_node(&pool, 64), 9);
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "Pool nodes should reach the global state");
+
+    uint32_t indices[4];
+    EmergencyActiveReport_t report = {.indices = indices, .capacity = 4};
+    EmergencyNodePool_collect_active(&pool, &report);
+    TEST_ASSERT(report.count == 2 && indices[0] == 17 && indices[1] == 64, "Scan should report handles");
+
+    TEST_ASSERT(EmergencyNodePool_release(&pool, 17) == 0, "Release should succeed");
+    TEST_ASSERT(EmergencyNodePool_release(&pool, 17) == -1, "Double release should fail");
+    TEST_ASSERT(EmergencyNodePool_release(&pool, 100) == -1, "Foreign handle should fail");
+    TEST_ASSERT(EmergencyNodePool_acquire(&pool) == 17, "Released handle should be reused");
+    TEST_ASSERT(EmergencyNode_counter(EmergencyNodePool_node(&pool, 17)) == 0, "Reused node should be clear");
+
+    EmergencyNodePool_release(&pool, 64);
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Release should solve the node");
+    EmergencyNode_raise(EmergencyNodePool_node(&pool, 5), 1);
+    EmergencyNodePool_destroy(&pool);
+    TEST_ASSERT(pool.nodes == NULL && pool.capacity == 0, "Destroy should reset the pool");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Destroy should release the global state");
+
+    TEST_PASS("Node pool");
+}
+
+static void* pool_worker(void* arg) {
+    EmergencyNodePool_t* pool = arg;
+    int32_t held[4];
+    for (int i = 0; i < 20000; i++) {
+        int taken = 0;
+        for (int k = 0; k < 4; k++) {
+            held[taken] = EmergencyNodePool_acquire(pool);
+            if (held[taken] >= 0) {
+                EmergencyNode_raise(EmergencyNodePool_node(pool, held[taken]), (uint8_t)k);
+                taken++;
+            }
+        }
+        while (taken) {
+            EmergencyNodePool_release(pool, held[--taken]);
+        }
+    }
+    return NULL;
+}
+
+void test_multithreaded_node_pool() {
+    printf("\n[MULTITHREAD] Testing concurrent pool acquire and release...\n");
+
+    EmergencyNodePool_t pool;
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    pthread_t threads[4];
+    TEST_ASSERT(EmergencyNodePool_create(&pool, 12) == 0, "Pool should be created");
+
+    const int32_t base = EmergencyNode_global_counter();
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, pool_worker, &pool);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Released nodes should leave the counter");
+
+    int acquired = 0;
+    while (EmergencyNodePool_acquire(&pool) >= 0) {
+        acquired++;
+    }
+    TEST_ASSERT(acquired == 12, "Every handle should be back in the pool");
+    EmergencyNodePool_destroy(&pool);
+
+    TEST_PASS("Concurrent pool acquire and release");
+}
+
+void test_range_init_destroy() {
+    printf("\n[EDGE CASE] Testing range init and destroy of 10000 nodes...\n");
+
+    const uint32_t NUM_NODES = 10000;
+    EmergencyNode_t* nodes = malloc(NUM_NODES * sizeof(*nodes));
+    EmergencyNode_t probe;
+    EmergencyNode_init(&probe);
+    TEST_ASSERT(nodes != NULL, "Node array allocation should succeed");
+
+    memset(nodes, 0xA5, NUM_NODES * sizeof(*nodes));
+    TEST_ASSERT(EmergencyNode_init_range(nodes, NUM_NODES) == 0, "Range init should succeed");
+    uint32_t raised = 0;
+    for (uint32_t i = 0; i < NUM_NODES; i++) {
+        TEST_ASSERT(EmergencyNode_counter(&nodes[i]) == 0, "Range init should clear every node");
+    }
+
+    const int32_t base = EmergencyNode_global_counter();
+    for (uint32_t i = 0; i < NUM_NODES; i += 3) {
+        EmergencyNode_raise(&nodes[i], (uint8_t)(i % 64));
+        EmergencyNode_raise(&nodes[i], (uint8_t)((i + 1) % 64));
+        raised++;
+    }
+    TEST_ASSERT(EmergencyNode_global_counter() == base + (int32_t)raised, "Every raised node should be counted");
+
+#if defined(EMERGENCY_GLOBAL_SPINLOCK) && defined(EMERGENCY_LOCK_PROFILE)
+    EmergencyLockProfile_t before;
+    EmergencyLockProfile_t after;
+    EmergencyNode_lock_profile(&before);
+#endif
+    TEST_ASSERT(EmergencyNode_destroy_range(nodes, NUM_NODES) == 0, "Range destroy should succeed");
+#if defined(EMERGENCY_GLOBAL_SPINLOCK) && defined(EMERGENCY_LOCK_PROFILE)
+    EmergencyNode_lock_profile(&after);
+    TEST_ASSERT(after.site[EMERGENCY_LOCK_SITE_SOLVED].acquisitions == before.site[EMERGENCY_LOCK_SITE_SOLVED].acquisitions + 1,
+                "Range destroy should take the lock once");
+#endif
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Range destroy should settle the counter");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) == 0, "Range destroy should release the global state");
+    for (uint32_t i = 0; i < NUM_NODES; i++) {
+        TEST_ASSERT(EmergencyNode_counter(&nodes[i]) == 0, "Range destroy should clear every node");
+    }
+    EmergencyNode_raise(&nodes[NUM_NODES - 1], 7);
+    TEST_ASSERT(EmergencyNode_global_counter() == base + 1, "Destroyed nodes should be usable again");
+    EmergencyNode_destroy_range(nodes, NUM_NODES);
+    free(nodes);
+
+    TEST_PASS("Range init and destroy");
+}
+
+void test_debounce_filter() {
+    printf("\n[RIGHT] Testing debounced raise and solve...\n");
+
+    EmergencyDebounceConfig_t config;
+    EmergencyDebounce_t filter;
+    EmergencyNode_t sensor;
+    EmergencyNode_t probe;
+    EmergencyNode_init(&sensor);
+    EmergencyNode_init(&probe);
+    EmergencyDebounce_config_init(&config, 1, 1);
+    EmergencyDebounce_config_set(&config, UINT64_C(1) << 4, 3, 5);
+    EmergencyDebounce_init(&filter, &sensor, &config);
+    TEST_ASSERT(EmergencyDebounce_raise(&filter, 64) == -1, "Exception above 63 should fail");
+
+    // flapping between ticks never reaches the node
+    const int32_t base = EmergencyNode_global_counter();
+    for (int tick = 0; tick < 10; tick++) {
+        for (int i = 0; i < 1000; i++) {
+            EmergencyDebounce_raise(&filter, 4);
+            EmergencyDebounce_solve(&filter, 4);
+        }
+        EmergencyDebounce_tick(&filter);
+    }
+    TEST_ASSERT(EmergencyNode_counter(&sensor) == 0, "Flapping input should not raise");
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Flapping input should not reach the counter");
+
+    EmergencyDebounce_raise(&filter, 4);
+    TEST_ASSERT(EmergencyDebounce_tick(&filter) == 0, "First tick should not raise");
+    TEST_ASSERT(EmergencyDebounce_tick(&filter) == 0, "Second tick should not raise");
+    TEST_ASSERT(EmergencyDebounce_tick(&filter) == 1, "Third tick should raise");
+    TEST_ASSERT(EmergencyNode_counter(&sensor) == 1, "Settled raise should reach the node");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&probe) != 0, "Settled raise should reach the global state");
+
+    // a bounce restarts the solve count
+    EmergencyDebounce_solve(&filter, 4);
+    for (int tick = 0; tick < 4; tick++) {
+        EmergencyDebounce_tick(&filter);
+    }
+    EmergencyDebounce_raise(&filter, 4);
+    EmergencyDebounce_tick(&filter);
+    EmergencyDebounce_solve(&filter, 4);
+    for (int tick = 0; tick < 4; tick++) {
+        TEST_ASSERT(EmergencyDebounce_tick(&filter) == 0, "Solve should wait for its full count");
+    }
+    TEST_ASSERT(EmergencyNode_counter(&sensor) == 1, "Exception should stay raised while counting");
+    TEST_ASSERT(EmergencyDebounce_tick(&filter) == 1, "Fifth quiet tick should solve");
+    TEST_ASSERT(EmergencyNode_counter(&sensor) == 0, "Settled solve should reach the node");
+
+    // other exceptions pass on the next tick, all as one mask
+    EmergencyDebounce_t filters[3];
+    EmergencyNode_t nodes[3];
+    for (int i = 0; i < 3; i++) {
+        EmergencyNode_init(&nodes[i]);
+        EmergencyDebounce_init(&filters[i], &nodes[i], &config);
+    }
+    EmergencyDebounce_raise(&filters[0], 1);
+    EmergencyDebounce_raise(&filters[0], 2);
+    EmergencyDebounce_raise(&filters[2], 9);
+    TEST_ASSERT(EmergencyDebounce_tick_all(filters, 3) == 3, "Batched tick should settle every filter");
+    TEST_ASSERT(EmergencyNode_counter(&nodes[0]) == 2 && EmergencyNode_counter(&nodes[2]) == 1, "Batched tick should raise the nodes");
+    TEST_ASSERT(EmergencyDebounce_tick_all(filters, 3) == 0, "Settled filters should not change");
+    for (int i = 0; i < 3; i++) {
+        EmergencyNode_destroy(&nodes[i]);
+    }
+    EmergencyNode_destroy(&sensor);
+
+    TEST_PASS("Debounced raise and solve");
+}
+
+void test_replay_invariants() {
+    printf("\n[CROSS-CHECK] Testing deterministic replay...\n");
+
+    static EmergencyReplayOp_t ops[512];
+    static uint8_t bytes[512 * EMERGENCY_REPLAY_OP_BYTES];
+    EmergencyReplayResult_t result;
+    const int32_t base = EmergencyNode_global_counter();
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        bytes[i] = (uint8_t) state;
+    }
+    const uint32_t count = EmergencyReplay_decode(bytes, sizeof(bytes) - 1, ops, 512);
+    TEST_ASSERT(count == 511, "Decode should ignore a partial trailing op");
+    TEST_ASSERT(EmergencyReplay_run(ops, count, &result) == 0, "Random sequence should keep every invariant");
+    TEST_ASSERT(result.ops_run == count && result.violated == EMERGENCY_REPLAY_OK, "Every op should be replayed");
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Replay should leave its nodes clear");
+
+    // masks take all eight of their bytes, so any 64-bit value can be decoded
+    const uint8_t mask_op[EMERGENCY_REPLAY_OP_BYTES] = {0xA0, 0x01, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF};
+    TEST_ASSERT(EmergencyReplay_decode(mask_op, sizeof(mask_op), ops, 1) == 1, "One op should be decoded");
+    TEST_ASSERT(ops[0].kind == EMERGENCY_REPLAY_RAISE_MASK && ops[0].mask == UINT64_C(0xEFCDAB8967452301),
+        "Mask should be decoded from its eight bytes");
+
+    const EmergencyReplayOp_t script[] = {
+        {.kind = EMERGENCY_REPLAY_RAISE, .node = 1, .exception = 3, .expected = 1},
+        {.kind = EMERGENCY_REPLAY_RAISE_MASK, .node = 1 | EMERGENCY_REPLAY_ATOMIC, .mask = 0xF0, .expected = 4},
+        {.kind = EMERGENCY_REPLAY_RAISE, .node = 1, .exception = 200, .expected = 1},
+        {.kind = EMERGENCY_REPLAY_DESTROY, .node = 1 | EMERGENCY_REPLAY_ATOMIC, .expected = 0},
+        {.kind = EMERGENCY_REPLAY_SOLVE, .node = 1, .exception = 3, .expected = 1},
+    };
+    TEST_ASSERT(EmergencyReplay_run(script, 4, &result) == 0, "Scripted ops should replay cleanly");
+    TEST_ASSERT(EmergencyReplay_run(script, 5, &result) == -1, "Wrong recorded counter should be reported");
+    TEST_ASSERT(result.failed_op == 4 && result.violated == EMERGENCY_REPLAY_RECORDED_COUNTER, "Failure should name the op and the invariant");
+    TEST_ASSERT(EmergencyReplay_run(script, 5, &result) == -1 && result.failed_op == 4, "Replay should be deterministic");
+
+    const EmergencyReplayOp_t bad = {.kind = EMERGENCY_REPLAY_RAISE, .node = EMERGENCY_REPLAY_NODES, .expected = EMERGENCY_REPLAY_UNCHECKED};
+    TEST_ASSERT(EmergencyReplay_run(&bad, 1, &result) == -1 && result.violated == EMERGENCY_REPLAY_BAD_OP, "Op on a missing node should be rejected");
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Failed replays should leave their nodes clear");
+
+    TEST_PASS("Deterministic replay");
+}
+
+void test_bulk_active_scan() {
+    printf("\n[RIGHT] Testing bulk scan for active nodes...\n");
+
+    // not a multiple of any kernel's block, so every tail path runs
+    const uint32_t NUM_NODES = 10003;
+    static const EmergencyScanKernel_t kernels[] = {
+        EMERGENCY_SCAN_SCALAR, EMERGENCY_SCAN_SSE2, EMERGENCY_SCAN_AVX2, EMERGENCY_SCAN_NEON,
+    };
+    EmergencyNodeArray_t array;
+    EmergencyNodeArray_t padded;
+    uint32_t* indices = malloc(NUM_NODES * sizeof(*indices));
+    TEST_ASSERT(indices != NULL, "Index allocation should succeed");
+    TEST_ASSERT(EmergencyNode_array_create(&array, NUM_NODES, EMERGENCY_LAYOUT_PACKED) == 0, "Packed array should be created");
+    TEST_ASSERT(EmergencyNode_array_create(&padded, NUM_NODES, EMERGENCY_LAYOUT_PADDED) == 0, "Padded array should be created");
+
+    uint32_t expected_count = 0;
+    uint32_t expected_exceptions = 0;
+    uint64_t expected_union = 0;
+    for (uint32_t i = 0; i < NUM_NODES; i++) {
+        // sparse runs, a dense block and the very last node
+        if (i % 97 == 3 || (i >= 4096 && i < 4130) || i == NUM_NODES - 1) {
+            const uint8_t exception = (uint8_t)(i % 64);
+            EmergencyNode_raise(EmergencyNode_array_at(&array, i), exception);
+            EmergencyNode_raise(EmergencyNode_array_at(&array, i), (uint8_t)((i * 7) % 64));
+            EmergencyNode_raise(EmergencyNode_array_at(&padded, i), exception);
+            EmergencyNode_raise(EmergencyNode_array_at(&padded, i), (uint8_t)((i * 7) % 64));
+            expected_count++;
+            expected_exceptions += EmergencyNode_counter(EmergencyNode_array_at(&array, i));
+            expected_union |= (UINT64_C(1) << exception) | (UINT64_C(1) << ((i * 7) % 64));
+        }
+    }
+
+    EmergencyActiveReport_t report = {.indices = indices, .capacity = NUM_NODES};
+    for (unsigned k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (EmergencyScan_select(kernels[k])) {
+            continue;
+        }
+        memset(indices, 0xFF, NUM_NODES * sizeof(*indices));
+        TEST_ASSERT(EmergencyNode_array_collect_active(&array, &report) == 0, "Scan should fit the index storage");
+        TEST_ASSERT(report.count == expected_count, "Every node in emergency should be found");
+        TEST_ASSERT(report.exceptions == expected_exceptions, "Active exceptions should be summed");
+        TEST_ASSERT(report.union_mask == expected_union, "Union mask should hold every active exception");
+
+        uint32_t previous = 0;
+        for (uint32_t r = 0; r < report.count; r++) {
+            TEST_ASSERT(EmergencyNode_counter(EmergencyNode_array_at(&array, indices[r])) > 0, "Reported nodes should be in emergency");
+            TEST_ASSERT(r == 0 || indices[r] > previous, "Indices should be ascending");
+            previous = indices[r];
+        }
+        TEST_ASSERT(indices[report.count - 1] == NUM_NODES - 1, "Last node should be found");
+    }
+    EmergencyScan_select(EMERGENCY_SCAN_AUTO);
+    TEST_ASSERT(EmergencyScan_kernel() != EMERGENCY_SCAN_AUTO, "Auto should resolve to a kernel");
+    TEST_ASSERT(EmergencyScan_select(EMERGENCY_SCAN_NEON + 1) == -1, "Unknown kernel should be rejected");
+
+    EmergencyActiveReport_t strided = {.indices = indices, .capacity = NUM_NODES};
+    EmergencyNode_array_collect_active(&padded, &strided);
+    TEST_ASSERT(strided.count == expected_count && strided.union_mask == expected_union, "Padded arrays should scan the same");
+
+    EmergencyActiveReport_t small = {.indices = indices, .capacity = 4};
+    TEST_ASSERT(EmergencyNode_collect_active(EmergencyNode_array_at(&array, 0), NUM_NODES, &small) == -1, "Too small storage should be reported");
+    TEST_ASSERT(small.count == expected_count, "Count should stay complete when truncated");
+    EmergencyActiveReport_t totals = {.indices = NULL, .capacity = 0};
+    TEST_ASSERT(EmergencyNode_collect_active(EmergencyNode_array_at(&array, 0), NUM_NODES, &totals) == 0,
+        "Totals-only scan should not be reported as truncated");
+    TEST_ASSERT(totals.count == expected_count && totals.exceptions == expected_exceptions
+        && totals.union_mask == expected_union, "Totals-only scan should be complete");
+    EmergencyActiveReport_t strided_totals = {.indices = NULL, .capacity = 0};
+    TEST_ASSERT(EmergencyNode_array_collect_active(&padded, &strided_totals) == 0,
+        "Totals-only strided scan should not be reported as truncated");
+    TEST_ASSERT(strided_totals.count == expected_count && strided_totals.union_mask == expected_union,
+        "Totals-only strided scan should be complete");
+    EmergencyActiveReport_t empty = {0};
+    TEST_ASSERT(EmergencyNode_collect_active(NULL, 0, &empty) == 0, "Empty scan should succeed");
+    TEST_ASSERT(empty.count == 0 && empty.union_mask == 0, "Empty scan should find nothing");
+
+    EmergencyNode_array_destroy(&array);
+    EmergencyNode_array_destroy(&padded);
+    free(indices);
+
+    TEST_PASS("Bulk scan for active nodes");
+}
+
+#ifdef EMERGENCY_TRACE
+static void* trace_raise_worker(void* arg) {
+    (void) arg;
+    EmergencyNode_t node;
+    EmergencyNode_init(&node);
+    EmergencyNode_raise(&node, 1);
+    EmergencyNode_destroy(&node);
+    return NULL;
+}
+
+void test_trace_histograms() {
+    printf("\n[RIGHT] Testing raise-to-LED trace histograms...\n");
+    
+    EmergencyTraceSnapshot_t before;
+    EmergencyTraceSnapshot_t after;
+    EmergencyNode_t node;
+    EmergencyNode_init(&node);
+    
+    for (uint32_t b = 1; b < EMERGENCY_TRACE_BUCKETS; b++) {
+        TEST_ASSERT(EmergencyTrace_bucket_value(b) > EmergencyTrace_bucket_value(b - 1), "Bucket values should increase");
+    }
+    TEST_ASSERT(EmergencyTrace_snapshot(EMERGENCY_TRACE_HISTOGRAMS, &before) == -1, "Unknown histogram should fail");
+    
+    EmergencyTrace_snapshot(EMERGENCY_TRACE_RAISE, &before);
+    const int was_on = EmergencyNode_is_emergency_state(&node);
+    EmergencyNode_raise(&node, 3);
+    EmergencyNode_raise(&node, 3);
+    EmergencyTrace_snapshot(EMERGENCY_TRACE_RAISE, &after);
+    TEST_ASSERT(after.count == before.count + 1, "Only the slow path raise should be recorded");
+    TEST_ASSERT(EmergencyTrace_percentile(&after, 1000) <= after.max, "Percentiles should not exceed the max");
+    
+    EmergencyTrace_snapshot(EMERGENCY_TRACE_RAISE_TO_LED, &after);
+    EmergencyNode_destroy(&node);
+#ifndef EMERGENCY_DEFERRED_LED
+    // deferred builds turn the LED on in the flush, outside any raise
+    TEST_ASSERT(was_on || after.count > 0, "Turning the LED on should be recorded");
+#else
+    (void) was_on;
+#endif
+    
+    // more threads over time than slots: exited threads give theirs back
+    EmergencyTrace_snapshot(EMERGENCY_TRACE_RAISE, &before);
+    for (int i = 0; i < EMERGENCY_TRACE_MAX_THREADS + 4; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, trace_raise_worker, NULL);
+        pthread_join(thread, NULL);
+    }
+    EmergencyTrace_snapshot(EMERGENCY_TRACE_RAISE, &after);
+    TEST_ASSERT(after.untracked_threads == before.untracked_threads, "Short-lived threads should reuse slots");
+    TEST_ASSERT(after.count == before.count + EMERGENCY_TRACE_MAX_THREADS + 4, "Every thread's raise should be recorded");
+    TEST_ASSERT(after.threads == before.threads, "Exited threads should no longer hold a slot");
+    TEST_ASSERT(after.threads >= 1, "This thread should still hold its slot");
+    
+    TEST_PASS("Raise-to-LED trace histograms");
+}
+#endif
+
+#ifdef EMERGENCY_LOCK_PROFILE
+void test_lock_profile() {
+    printf("\n[RIGHT] Testing global lock profile...\n");
+    
+    EmergencyLockProfile_t before;
+    EmergencyLockProfile_t after;
+    EmergencyNode_t node;
+    EmergencyNode_init(&node);
+    
+#ifdef EMERGENCY_GLOBAL_SPINLOCK
+    TEST_ASSERT(EmergencyNode_lock_profile(&before) == 0, "Profile should be available");
+    EmergencyNode_raise(&node, 1);
+    EmergencyNode_solve(&node, 1);
+    EmergencyNode_is_emergency_state(&node);
+    TEST_ASSERT(EmergencyNode_lock_profile(&after) == 0, "Profile should be available");
+    
+    for (int site = 0; site < EMERGENCY_LOCK_SITES; site++) {
+#ifdef EMERGENCY_DEFERRED_LED
+        // the LED is written by the flush, so raise never takes the lock for it
+        if (site == EMERGENCY_LOCK_SITE_HW_RAISE) {
+            TEST_ASSERT(after.site[site].acquisitions == before.site[site].acquisitions, "Raise should not lock for the LED");
+            continue;
+        }
+#endif
+        TEST_ASSERT(after.site[site].acquisitions == before.site[site].acquisitions + 1, "Every site should be taken once");
+        TEST_ASSERT(after.site[site].max_hold_cycles >= before.site[site].max_hold_cycles, "Max hold should not shrink");
+    }
+    
+    static EmergencySystemSnapshot_t snapshot;
+    TEST_ASSERT(EmergencySystem_snapshot(&snapshot) == 0, "Snapshot should succeed without writers");
+    TEST_ASSERT(EmergencyNode_lock_profile(&before) == 0, "Profile should be available");
+    TEST_ASSERT(before.site[EMERGENCY_LOCK_SITE_READ].acquisitions == after.site[EMERGENCY_LOCK_SITE_READ].acquisitions, "Snapshots should read the counter without the lock");
+    
+    EmergencyNode_lock_profile_reset();
+    EmergencyNode_lock_profile(&after);
+    TEST_ASSERT(after.site[EMERGENCY_LOCK_SITE_INCREASE].acquisitions == 0, "Reset should clear the profile");
+#else
+    (void) after;
+    TEST_ASSERT(EmergencyNode_lock_profile(&before) == -1, "Lock-free builds have no lock to profile");
+#endif
+    EmergencyNode_destroy(&node);
+    
+    TEST_PASS("Global lock profile");
+}
+#endif
+
+#ifdef EMERGENCY_EVENTS
+void test_event_ring() {
+    printf("\n[RIGHT] Testing raise/solve event ring...\n");
+    
+    static EmergencyEvent_t events[EMERGENCY_EVENTS_CAPACITY];
+    EmergencyNode_t node;
+    EmergencyNode_init(&node);
+    while (EmergencyEvents_drain(events, EMERGENCY_EVENTS_CAPACITY));
+    
+    EmergencyNode_raise(&node, 4);
+    EmergencyNode_raise(&node, 4);
+    EmergencyNode_raise_mask(&node, 0x70);
+    EmergencyNode_solve(&node, 7);
+    EmergencyNode_solve(&node, 4);
+    EmergencyNode_destroy(&node);
+    
+    const uint32_t count = EmergencyEvents_drain(events, EMERGENCY_EVENTS_CAPACITY);
+    TEST_ASSERT(count == 5, "Only real bit changes should be recorded");
+    TEST_ASSERT(events[0].kind == EMERGENCY_EVENT_RAISE && events[0].exception == 4 && events[0].node_counter == 1, "First event should be the raise of 4");
+    TEST_ASSERT(events[1].exception == 5 && events[2].exception == 6 && events[2].node_counter == 3, "Mask raise should skip the bit already set");
+    TEST_ASSERT(events[3].kind == EMERGENCY_EVENT_SOLVE && events[3].exception == 4 && events[3].node_counter == 2, "Solve should be recorded");
+    TEST_ASSERT(events[4].kind == EMERGENCY_EVENT_CLEAR && events[4].node == &node, "Destroy should be recorded");
+    for (uint32_t i = 1; i < count; i++) {
+        TEST_ASSERT(events[i].timestamp_ns >= events[i - 1].timestamp_ns, "Events should be in order");
+    }
+    
+    const uint64_t dropped = EmergencyEvents_dropped();
+    for (uint32_t i = 0; i <= EMERGENCY_EVENTS_CAPACITY; i++) {
+        EmergencyNode_raise(&node, 1);
+        EmergencyNode_solve(&node, 1);
+    }
+    TEST_ASSERT(EmergencyEvents_dropped() > dropped, "A full ring should drop instead of blocking");
+    TEST_ASSERT(EmergencyEvents_drain(events, EMERGENCY_EVENTS_CAPACITY) == EMERGENCY_EVENTS_CAPACITY, "A full ring should drain completely");
+    TEST_ASSERT(EmergencyEvents_drain(events, EMERGENCY_EVENTS_CAPACITY) == 0, "Drained ring should be empty");
+    
+    TEST_PASS("Raise/solve event ring");
+}
+
+void test_event_replay() {
+    printf("\n[CROSS-CHECK] Testing replay of recorded events...\n");
+
+    static EmergencyEvent_t events[EMERGENCY_EVENTS_CAPACITY];
+    static EmergencyReplayOp_t ops[EMERGENCY_EVENTS_CAPACITY];
+    EmergencyReplayResult_t result;
+    EmergencyNode_t plain[2];
+    EmergencyNodeAtomic_t shared;
+    EmergencyNode_t other;
+    EmergencyNode_init_range(plain, 2);
+    EmergencyNodeAtomic_init(&shared);
+    EmergencyNode_init(&other);
+    while (EmergencyEvents_drain(events, EMERGENCY_EVENTS_CAPACITY));
+
+    for (uint8_t i = 0; i < 50; i++) {
+        EmergencyNode_raise(&plain[i % 2], i % 7);
+        EmergencyNodeAtomic_raise_mask(&shared, 0x3ull << (i % 9));
+        EmergencyNode_raise(&other, i % 5);
+        if (i % 3 == 0) {
+            EmergencyNode_solve_mask(&plain[(i + 1) % 2], 0x5);
+            EmergencyNodeAtomic_solve(&shared, i % 9);
+        }
+        if (i % 11 == 10) {
+            EmergencyNode_destroy(&plain[0]);
+        }
+    }
+    EmergencyNode_destroy_range(plain, 2);
+    EmergencyNodeAtomic_destroy(&shared);
+    EmergencyNode_destroy(&other);
+
+    const uint32_t count = EmergencyEvents_drain(events, EMERGENCY_EVENTS_CAPACITY);
+    const uint32_t recorded = EmergencyReplay_record(events, count, plain, 2, &shared, 1, ops, EMERGENCY_EVENTS_CAPACITY);
+    TEST_ASSERT(recorded > 0 && recorded < count, "Events of unlisted nodes should be skipped");
+    TEST_ASSERT(EmergencyReplay_run(ops, recorded, &result) == 0, "Recorded run should replay with its counters");
+    TEST_ASSERT(result.ops_run == recorded, "Every recorded op should be replayed");
+    while (EmergencyEvents_drain(events, EMERGENCY_EVENTS_CAPACITY));
+
+    TEST_PASS("Replay of recorded events");
+}
+#endif
+
+#ifdef EMERGENCY_EXPORT
+void test_shared_memory_export() {
+    printf("\n[RIGHT] Testing shared-memory export of the registry...\n");
+    
+    char name[64];
+    snprintf(name, sizeof(name), "/emergency_test_%d", (int)getpid());
+    static EmergencyExportSnapshot_t snapshot;
+    
+    EmergencyNodeAtomic_t* held = EmergencyRegistry_acquire();
+    TEST_ASSERT(EmergencyRegistry_export(name) == -1, "Export with acquired nodes should fail");
+    EmergencyRegistry_release(held);
+    
+    // a segment of that name left by another process is never taken over
+    const int stale = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    TEST_ASSERT(stale >= 0, "Stale segment should be created");
+    close(stale);
+    TEST_ASSERT(EmergencyRegistry_export(name) == -1, "Export over an existing segment should fail");
+    shm_unlink(name);
+    
+    const int32_t base = EmergencyNode_global_counter();
+    // edges of unregistered nodes racing the export must all reach the segment counter
+    const int NUM_RACERS = 2;
+    pthread_t racers[NUM_RACERS];
+    ThreadTestData racer_data[NUM_RACERS];
+    EmergencyNodeAtomic_t racer_nodes[NUM_RACERS];
+    for (int i = 0; i < NUM_RACERS; i++) {
+        EmergencyNodeAtomic_init(&racer_nodes[i]);
+        racer_data[i].node = &racer_nodes[i];
+        racer_data[i].thread_id = i;
+        racer_data[i].iterations = 20000;
+        pthread_create(&racers[i], NULL, thread_global_toggle_worker, &racer_data[i]);
+    }
+    const int8_t exported = EmergencyRegistry_export(name);
+    for (int i = 0; i < NUM_RACERS; i++) {
+        pthread_join(racers[i], NULL);
+    }
+    TEST_ASSERT(exported == 0, "Export should succeed");
+    TEST_ASSERT(EmergencyRegistry_export(name) == -1, "Second export should fail");
+    const EmergencyRegistryLayout_t* view = EmergencyExport_attach(name);
+    TEST_ASSERT(view != NULL, "Reader should attach to the segment");
+    TEST_ASSERT(EmergencyExport_read(view, &snapshot) == 0 && snapshot.global_counter == base,
+        "Edges racing the export should keep the segment counter exact");
+    
+    EmergencyNodeAtomic_t* node = EmergencyRegistry_acquire();
+    TEST_ASSERT(node != NULL, "Acquire should hand out shared nodes");
+    EmergencyNodeAtomic_raise(node, 9);
+    TEST_ASSERT(EmergencyExport_read(view, &snapshot) == 0, "Read should succeed without writers");
+    const int16_t index = EmergencyRegistry_index(node);
+    TEST_ASSERT(snapshot.nodes[index] == (UINT64_C(1) << 9), "Reader should see the raised bit");
+    TEST_ASSERT(snapshot.allocated[index / 64] & (UINT64_C(1) << (index % 64)), "Reader should see the node allocated");
+    TEST_ASSERT(snapshot.global_counter == base + 1, "Reader should see the global counter");
+    
+    const uint64_t version = snapshot.version;
+    EmergencyRegistry_release(node);
+    EmergencyExport_read(view, &snapshot);
+    TEST_ASSERT(snapshot.version > version, "Every change should advance the version");
+    TEST_ASSERT(snapshot.nodes[index] == 0 && snapshot.global_counter == base, "Release should reach the reader");
+    
+    // a monitor polling the segment while registered nodes are under steady load
+    const int NUM_THREADS = 4;
+    pthread_t threads[NUM_THREADS];
+    ThreadTestData thread_data[NUM_THREADS];
+    int16_t indices[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        thread_data[i].node = EmergencyRegistry_acquire();
+        TEST_ASSERT(thread_data[i].node != NULL, "Acquire should hand out shared nodes");
+        indices[i] = EmergencyRegistry_index(thread_data[i].node);
+        thread_data[i].thread_id = i;
+        thread_data[i].iterations = 20000;
+        pthread_create(&threads[i], NULL, thread_global_toggle_worker, &thread_data[i]);
+    }
+    int consistent = 0;
+    int conflicted = 0;
+    int wrong = 0;
+    for (int r = 0; r < 2000; r++) {
+        const int8_t status = EmergencyExport_read(view, &snapshot);
+        if (status) {
+            conflicted++;
+            wrong += status != -1;
+            // the opt-in fallback always has a copy, flagged when unchecked
+            const int8_t fallback = EmergencyExport_read_best_effort(view, &snapshot);
+            wrong += fallback != 0 && (fallback != 1 || snapshot.version != 0);
+            sched_yield();
+            continue;
+        }
+        int32_t active = 0;
+        for (int i = 0; i < NUM_THREADS; i++) {
+            active += snapshot.nodes[indices[i]] != 0;
+        }
+        consistent++;
+        wrong += snapshot.global_counter != base + active;
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        EmergencyRegistry_release(thread_data[i].node);
+    }
+    TEST_ASSERT(wrong == 0, "Reads under writers should be consistent copies or fail with -1");
+    TEST_ASSERT(consistent + conflicted == 2000 && consistent > 0, "Reads under writers should keep succeeding");
+    TEST_ASSERT(EmergencyExport_read_best_effort(view, &snapshot) == 0, "Best-effort read should be checked without writers");
+    
+    EmergencyExport_detach(view);
+    shm_unlink(name);
+    
+    TEST_PASS("Shared-memory export of the registry");
+}
+#endif
+
+#ifdef EMERGENCY_DEFERRED_LED
+extern atomic_ushort emergency_led;
+
+static void* flush_worker(void* arg) {
+    (void) arg;
+    for (int i = 0; i < 20000; i++) {
+        EmergencyNode_led_flush();
+    }
+    return NULL;
+}
+
+void test_deferred_led() {
+    printf("\n[RIGHT] Testing the deferred LED flush...\n");
+    
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
+    settle_led();
+    TEST_ASSERT(atomic_load(&emergency_led) == 0, "LED should start off");
+    
+    EmergencyNodeAtomic_raise(&node, 2);
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 1, "State should be up before the flush");
+    TEST_ASSERT(atomic_load(&emergency_led) == 0, "Raise should not write the LED");
+    usleep(EMERGENCY_LED_PERIOD_NS / 1000 + 1);
+    TEST_ASSERT(EmergencyNode_led_flush() == 1, "Flush should write the LED");
+    TEST_ASSERT(atomic_load(&emergency_led) == 1, "LED should be on after the flush");
+    TEST_ASSERT(EmergencyNode_led_flush() == 0, "Flush without edges should not write");
+    
+    EmergencyNodeAtomic_solve(&node, 2);
+    TEST_ASSERT(EmergencyNode_led_flush() == 0, "Flush within the period should not write");
+    TEST_ASSERT(atomic_load(&emergency_led) == 1, "LED should stay on until the period passed");
+    
+    // a burst of edges coalesces into the final state
+    for (int i = 0; i < 1000; i++) {
+        EmergencyNodeAtomic_raise(&node, 2);
+        EmergencyNodeAtomic_solve(&node, 2);
+    }
+    usleep(EMERGENCY_LED_PERIOD_NS / 1000 + 1);
+    TEST_ASSERT(EmergencyNode_led_flush() == 1, "Flush after the period should write once");
+    TEST_ASSERT(atomic_load(&emergency_led) == 0, "LED should show the final state");
+    
+    EmergencyNodeAtomic_raise(&node, 2);
+    EmergencyNodeAtomic_solve(&node, 2);
+    settle_led();
+    TEST_ASSERT(atomic_load(&emergency_led) == 0, "Edges that cancel out should leave the LED alone");
+    
+    // a periodic tick and a worker may flush at the same time
+    pthread_t flushers[2];
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&flushers[i], NULL, flush_worker, NULL);
+    }
+    for (int i = 0; i < 2000; i++) {
+        EmergencyNodeAtomic_raise(&node, 3);
+        EmergencyNodeAtomic_solve(&node, 3);
+    }
+    EmergencyNodeAtomic_raise(&node, 3);
+    for (int i = 0; i < 2; i++) {
+        pthread_join(flushers[i], NULL);
+    }
+    settle_led();
+    TEST_ASSERT(atomic_load(&emergency_led) == 1, "Concurrent flushers should leave the final state");
+    EmergencyNodeAtomic_solve(&node, 3);
+    settle_led();
+    TEST_ASSERT(atomic_load(&emergency_led) == 0, "LED should go off after the last solve");
+    
+    TEST_PASS("Deferred LED flush");
+}
+#endif
+
+#ifdef EMERGENCY_TIMING
+typedef struct {
+    const void* node;
+    atomic_int tracked;
+} TrackRace;
+
+static void* track_worker(void* arg) {
+    TrackRace* race = arg;
+    if (EmergencyTiming_track(race->node) == 0) {
+        atomic_fetch_add(&race->tracked, 1);
+    }
+    return NULL;
+}
+
+void test_time_in_emergency() {
+    printf("\n[RIGHT] Testing time-in-emergency accounting...\n");
+
+    EmergencyNode_t motor;
+    EmergencyNodeAtomic_t cell;
+    EmergencyNode_t untracked;
+    EmergencyTimingStats_t stats;
+    EmergencyNode_init(&motor);
+    EmergencyNodeAtomic_init(&cell);
+    EmergencyNode_init(&untracked);
+
+    TEST_ASSERT(EmergencyTiming_track(&motor) == 0, "Node should be tracked");
+    TEST_ASSERT(EmergencyTiming_track(&motor) == -1, "Node should be tracked once");
+    TEST_ASSERT(EmergencyTiming_track(&cell) == 0, "Atomic node should be tracked");
+    TEST_ASSERT(EmergencyTiming_stats(&untracked, 0, &stats) == -1, "Untracked node should have no stats");
+    TEST_ASSERT(EmergencyTiming_stats(&motor, 64, &stats) == -1, "Exception above 63 should fail");
+
+    EmergencyNode_raise(&motor, 3);
+    usleep(2000);
+    // a re-raise keeps the first timestamp
+    EmergencyNode_raise(&motor, 3);
+    EmergencyTiming_stats(&motor, 3, &stats);
+    TEST_ASSERT(stats.activations == 0 && stats.active_cycles > 0, "Running activation should be active");
+    EmergencyNode_solve(&motor, 3);
+    EmergencyNode_solve(&motor, 3);
+    EmergencyTiming_stats(&motor, 3, &stats);
+    TEST_ASSERT(stats.activations == 1, "One activation should be counted");
+    TEST_ASSERT(stats.active_cycles == 0, "Solved exception should not be active");
+    TEST_ASSERT(stats.max_cycles == stats.total_cycles, "One activation is its own max");
+    TEST_ASSERT(EmergencyTiming_cycles_to_ns(stats.total_cycles) >= 1000000, "Duration should cover the sleep");
+
+    EmergencyNode_raise(&motor, 3);
+    EmergencyNode_solve(&motor, 3);
+    EmergencyTiming_stats(&motor, 3, &stats);
+    TEST_ASSERT(stats.activations == 2 && stats.max_cycles < stats.total_cycles, "Activations should add up");
+
+    EmergencyNode_raise_mask(&motor, UINT64_C(0x30));
+    EmergencyNode_destroy(&motor);
+    EmergencyTiming_stats(&motor, 5, &stats);
+    TEST_ASSERT(stats.activations == 1, "Destroy should end the activation");
+
+    EmergencyNodeAtomic_raise(&cell, 9);
+    EmergencyNodeAtomic_solve_mask(&cell, UINT64_C(1) << 9);
+    EmergencyTiming_stats(&cell, 9, &stats);
+    TEST_ASSERT(stats.activations == 1, "Atomic node edges should be timed");
+
+    TEST_ASSERT(EmergencyTiming_untrack(&motor) == 0, "Untrack should succeed");
+    TEST_ASSERT(EmergencyTiming_stats(&motor, 3, &stats) == -1, "Untracked node should lose its stats");
+    EmergencyTiming_untrack(&cell);
+
+    // racing tracks of one node must claim a single slot
+    pthread_t trackers[4];
+    TrackRace race = {.node = &cell};
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&trackers[i], NULL, track_worker, &race);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(trackers[i], NULL);
+    }
+    TEST_ASSERT(atomic_load(&race.tracked) == 1, "Only one concurrent track should succeed");
+    EmergencyNodeAtomic_raise(&cell, 2);
+    EmergencyNodeAtomic_solve(&cell, 2);
+    EmergencyTiming_stats(&cell, 2, &stats);
+    TEST_ASSERT(stats.activations == 1, "The node's edges should be counted once");
+    TEST_ASSERT(EmergencyTiming_untrack(&cell) == 0 && EmergencyTiming_untrack(&cell) == -1, "One untrack should free the node");
+    EmergencyNodeAtomic_destroy(&cell);
+
+    TEST_PASS("Time-in-emergency accounting");
+}
+#endif
+
+#ifdef EMERGENCY_CONTEXTS
+typedef struct {
+    EmergencyContext_t* context;
+    int iterations;
+    int settled;
+} ContextWorkerData;
+
+static void* context_worker(void* arg) {
+    ContextWorkerData* data = arg;
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init_in(&node, data->context);
+    for (int i = 0; i < data->iterations; i++) {
+        EmergencyNodeAtomic_raise(&node, i % 64);
+        EmergencyNodeAtomic_solve(&node, i % 64);
+    }
+    data->settled = EmergencyContext_global_counter(data->context) == 0;
+    return NULL;
+}
+
+void test_independent_contexts() {
+    printf("\n[RIGHT] Testing independent emergency contexts...\n");
+    
+    static EmergencyContext_t powertrain;
+    static EmergencyContext_t bms;
+    static atomic_ushort powertrain_led __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+    static atomic_ushort bms_led __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+    EmergencyNode_t motor;
+    EmergencyNodeAtomic_t cell;
+    EmergencyNode_t plain;
+    
+    TEST_ASSERT(EmergencyContext_init(&powertrain, &powertrain_led) == 0, "Context init should succeed");
+    TEST_ASSERT(EmergencyContext_init(&bms, &bms_led) == 0, "Second context init should succeed");
+    EmergencyNode_init_in(&motor, &powertrain);
+    EmergencyNodeAtomic_init_in(&cell, &bms);
+    EmergencyNode_init(&plain);
+    const int32_t base = EmergencyNode_global_counter();
+    
+    EmergencyNode_raise(&motor, 4);
+    settle_led();
+#ifdef EMERGENCY_DEFERRED_LED
+    usleep(EMERGENCY_LED_PERIOD_NS / 1000 + 1);
+    EmergencyContext_led_flush(&powertrain);
+#endif
+    TEST_ASSERT(EmergencyContext_global_counter(&powertrain) == 1, "Raise should count in its own context");
+    TEST_ASSERT(EmergencyContext_global_counter(&bms) == 0, "Other contexts should not see it");
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Default context should not see it");
+    TEST_ASSERT(atomic_load(&powertrain_led) == 1 && atomic_load(&bms_led) == 0, "Only the own LED should turn on");
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&cell) == 0, "Nodes of other contexts should stay clear");
+    TEST_ASSERT(EmergencyNode_is_emergency_state(&plain) == (base > 0), "Default nodes should ignore other contexts");
+    
+    EmergencyNodeAtomic_raise(&cell, 1);
+    EmergencyNode_destroy(&motor);
+    EmergencyNode_raise(&motor, 4);
+    TEST_ASSERT(EmergencyContext_global_counter(&powertrain) == 1, "Destroy should keep the node bound");
+    EmergencyNode_solve(&motor, 4);
+    EmergencyNodeAtomic_solve(&cell, 1);
+#ifdef EMERGENCY_DEFERRED_LED
+    usleep(EMERGENCY_LED_PERIOD_NS / 1000 + 1);
+    EmergencyContext_led_flush(&powertrain);
+    EmergencyContext_led_flush(&bms);
+#endif
+    TEST_ASSERT(EmergencyContext_global_state(&powertrain) == 0 && EmergencyContext_global_state(&bms) == 0, 
+                "Both contexts should be clear again");
+    TEST_ASSERT(atomic_load(&powertrain_led) == 0 && atomic_load(&bms_led) == 0, "Both LEDs should be off");
+    
+    // one domain per thread
+    pthread_t threads[2];
+    ContextWorkerData data[2] = {{&powertrain, 20000, 0}, {&bms, 20000, 0}};
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, context_worker, &data[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT(data[0].settled && data[1].settled, "Every domain should end clear");
+    TEST_ASSERT(EmergencyNode_global_counter() == base, "Default context should be untouched");
+    
+    TEST_PASS("Independent emergency contexts");
+}
+
+#define TREE_GROUPS 6
+#define TREE_FAN_OUT 2
+
+static EmergencyContext_t tree_root;
+static EmergencyContext_t tree_groups[TREE_GROUPS];
+static atomic_ushort tree_root_led;
+static atomic_ushort tree_leds[TREE_GROUPS];
+
+// deferred builds move every level with its own flush, leaves first
+static void settle_tree(void) {
+#ifdef EMERGENCY_DEFERRED_LED
+    for (int i = TREE_GROUPS - 1; i >= 0; i--) {
+        usleep(EMERGENCY_LED_PERIOD_NS / 1000 + 1);
+        EmergencyContext_led_flush(&tree_groups[i]);
+    }
+    usleep(EMERGENCY_LED_PERIOD_NS / 1000 + 1);
+    EmergencyContext_led_flush(&tree_root);
+#endif
+}
+
+typedef struct {
+    EmergencyContext_t* visited[TREE_GROUPS];
+    uint8_t depth[TREE_GROUPS];
+    uint32_t count;
+} TreeWalk;
+
+static void record_group(void* arg, EmergencyContext_t* group, uint8_t depth) {
+    TreeWalk* walk = arg;
+    walk->visited[walk->count] = group;
+    walk->depth[walk->count] = depth;
+    walk->count++;
+}
+
+static void* tree_leaf_worker(void* arg) {
+    EmergencyNodeAtomic_t* leaf = arg;
+    for (int i = 0; i < 20000; i++) {
+        EmergencyNodeAtomic_raise(leaf, 7);
+        EmergencyNodeAtomic_solve(leaf, 7);
+    }
+    return NULL;
+}
+
+void test_aggregation_tree() {
+    printf("\n[RIGHT] Testing the hierarchical aggregation tree...\n");
+    
+    // root <- groups 0, 1; group 0 <- groups 2, 3; group 1 <- groups 4, 5
+    EmergencyContext_init(&tree_root, &tree_root_led);
+    TEST_ASSERT(EmergencyContext_init_tree(tree_groups, tree_leds, TREE_GROUPS, 1, &tree_root) == -1, "Fan-out below 2 should be rejected");
+    TEST_ASSERT(EmergencyContext_init_tree(tree_groups, tree_leds, TREE_GROUPS, TREE_FAN_OUT, &tree_root) == 0, "Tree should be built");
+    
+    EmergencyNodeAtomic_t leaves[4];
+    for (int i = 0; i < 4; i++) {
+        EmergencyNodeAtomic_init_in(&leaves[i], &tree_groups[2 + i]);
+    }
+    
+    TreeWalk walk = {0};
+    TEST_ASSERT(EmergencyContext_walk_active(&tree_root, record_group, &walk) == 0, "Clear tree should have no active group");
+    
+    EmergencyNodeAtomic_raise(&leaves[1], 3);
+    settle_tree();
+    TEST_ASSERT(EmergencyContext_global_counter(&tree_groups[3]) == 1, "Leaf should count in its group");
+    TEST_ASSERT(EmergencyContext_global_counter(&tree_groups[0]) == 1, "Group edge should reach the parent group");
+    TEST_ASSERT(EmergencyContext_global_counter(&tree_root) == 1, "Group edge should reach the root");
+    TEST_ASSERT(atomic_load(&tree_root_led) == 1, "Root LED should turn on");
+    
+    EmergencyNodeAtomic_raise(&leaves[0], 3);
+    EmergencyNodeAtomic_raise(&leaves[1], 4);
+    settle_tree();
+    TEST_ASSERT(EmergencyContext_global_counter(&tree_groups[0]) == 2, "Second group should count in the parent");
+    TEST_ASSERT(EmergencyContext_global_counter(&tree_root) == 1, "Root should only see one subsystem edge");
+    
+    walk.count = 0;
+    TEST_ASSERT(EmergencyContext_walk_active(&tree_root, record_group, &walk) == 3, "Walk should visit the active groups");
+    TEST_ASSERT(walk.visited[0] == &tree_groups[0] && walk.depth[0] == 0, "Walk should start at the subsystem");
+    TEST_ASSERT(walk.visited[1] == &tree_groups[2] && walk.visited[2] == &tree_groups[3] && walk.depth[1] == 1, 
+                "Walk should descend into the active groups only");
+    
+    EmergencyNodeAtomic_destroy(&leaves[0]);
+    EmergencyNodeAtomic_solve_mask(&leaves[1], 0x18);
+    settle_tree();
+    TEST_ASSERT(EmergencyContext_global_counter(&tree_root) == 0, "Root should clear with its leaves");
+    TEST_ASSERT(atomic_load(&tree_root_led) == 0, "Root LED should turn off");
+    
+    // leaves under different subsystems hammered concurrently
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, tree_leaf_worker, &leaves[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    settle_tree();
+    for (int i = 0; i < TREE_GROUPS; i++) {
+        TEST_ASSERT(EmergencyContext_global_counter(&tree_groups[i]) == 0, "Every group should settle clear");
+        TEST_ASSERT(atomic_load(&tree_leds[i]) == 0, "Every group LED should be off");
+    }
+    TEST_ASSERT(EmergencyContext_global_counter(&tree_root) == 0 && atomic_load(&tree_root_led) == 0, "Root should settle clear");
+    
+    TEST_PASS("Hierarchical aggregation tree");
+}
+#endif
+
+#ifdef EMERGENCY_SEVERITY
+static void* severity_worker(void* arg) {
+    EmergencyNodeAtomic_t* node = arg;
+    for (int i = 0; i < 20000; i++) {
+        // one warning and one shutdown exception per round
+        EmergencyNodeAtomic_raise_mask(node, UINT64_C(0x0101));
+        EmergencyNodeAtomic_solve(node, 0);
+        EmergencyNodeAtomic_solve(node, 8);
+    }
+    return NULL;
+}
+
+void test_severity_classes() {
+    printf("\n[RIGHT] Testing severity classes...\n");
+    
+    EmergencyNode_t motor;
+    EmergencyNodeAtomic_t cell;
+    EmergencyNode_init(&motor);
+    EmergencyNodeAtomic_init(&cell);
+    
+    TEST_ASSERT(EmergencySeverity_map(EMERGENCY_SEVERITY_CLASSES, 1) == -1, "Unknown class should be rejected");
+    EmergencySeverity_map(EMERGENCY_SEVERITY_WARNING, UINT64_C(0x00FF));
+    EmergencySeverity_map(EMERGENCY_SEVERITY_DERATE, UINT64_C(0x0F00));
+    EmergencySeverity_map(EMERGENCY_SEVERITY_SHUTDOWN, UINT64_C(0xF000));
+    // remapping moves the exception out of its old class
+    EmergencySeverity_map(EMERGENCY_SEVERITY_SHUTDOWN, UINT64_C(0x0100));
+    TEST_ASSERT(EmergencySeverity_of(8) == EMERGENCY_SEVERITY_SHUTDOWN, "Remapped exception should change class");
+    TEST_ASSERT(EmergencySeverity_of(40) == EMERGENCY_SEVERITY_NONE, "Unmapped exception should have no class");
+    TEST_ASSERT(EmergencySeverity_highest() == EMERGENCY_SEVERITY_NONE, "Nothing should be active");
+    
+    EmergencyNode_raise(&motor, 2);
+    EmergencyNode_raise(&motor, 40);
+    TEST_ASSERT(EmergencySeverity_highest() == EMERGENCY_SEVERITY_WARNING, "Warning should be the highest");
+    
+    EmergencyNodeAtomic_raise_mask(&cell, UINT64_C(0x0600));
+    TEST_ASSERT(EmergencySeverity_highest() == EMERGENCY_SEVERITY_DERATE, "Derate should outrank warning");
+    TEST_ASSERT(EmergencySeverity_count(EMERGENCY_SEVERITY_DERATE) == 2, "Both derate exceptions should count");
+    
+    EmergencyNode_raise_mask(&motor, UINT64_C(0x3000));
+    TEST_ASSERT(EmergencySeverity_highest() == EMERGENCY_SEVERITY_SHUTDOWN, "Shutdown should be the highest");
+    TEST_ASSERT(EmergencySeverity_active() == 0x7, "Every class should be active");
+    
+    EmergencyNode_solve_mask(&motor, UINT64_C(0x3000));
+    TEST_ASSERT(EmergencySeverity_highest() == EMERGENCY_SEVERITY_DERATE, "Solving shutdown should fall back to derate");
+    EmergencyNodeAtomic_solve(&cell, 9);
+    TEST_ASSERT(EmergencySeverity_count(EMERGENCY_SEVERITY_DERATE) == 1, "Solve should lower the class count");
+    EmergencyNodeAtomic_destroy(&cell);
+    TEST_ASSERT(EmergencySeverity_highest() == EMERGENCY_SEVERITY_WARNING, "Destroy should clear its classes");
+    EmergencyNode_destroy(&motor);
+    TEST_ASSERT(EmergencySeverity_highest() == EMERGENCY_SEVERITY_NONE, "Destroy should leave nothing active");
+    
+    pthread_t threads[4];
+    EmergencyNodeAtomic_t nodes[4];
+    for (int i = 0; i < 4; i++) {
+        EmergencyNodeAtomic_init(&nodes[i]);
+        pthread_create(&threads[i], NULL, severity_worker, &nodes[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT(EmergencySeverity_count(EMERGENCY_SEVERITY_WARNING) == 0 &&
+                EmergencySeverity_count(EMERGENCY_SEVERITY_SHUTDOWN) == 0, "Counts should settle at zero");
+    TEST_ASSERT(EmergencySeverity_active() == 0, "Summary should settle clear");
+    
+    // leave the mapping empty for later tests
+    for (uint8_t c = 0; c < EMERGENCY_SEVERITY_CLASSES; c++) {
+        EmergencySeverity_map(c, 0);
+    }
+    
+    TEST_PASS("Severity classes");
+}
+#endif
+
 // ====================
 // MAIN TEST RUNNER
 // ====================
@@ -439,10 +1991,13 @@ int main(void) {
     test_node_init_right();
     test_raise_emergency_right();
     test_solve_emergency_right();
+    test_mask_raise_solve_right();
+    test_sized_nodes_right();
     
     test_raise_solve_inverse();
     
     test_emergency_state_cross_check(); 
+    test_registry_cross_check();
     
     test_boundary_conditions_error();
     test_solve_nonexistent_error();
@@ -450,12 +2005,51 @@ int main(void) {
     
     test_performance_many_operations();
     
+    test_multithreaded_global_counter();
     test_multithreaded_raise();
     test_multithreaded_raise_and_solve();
     test_multithreaded_stress();
+    test_multithreaded_system_snapshot();
+    test_change_notification();
+    test_multithreaded_notify_wait();
+    test_multithreaded_notify_subscribe_race();
     
     test_all_emergencies_simultaneously();
     test_byte_boundary_emergencies();
+    test_node_array_layouts();
+    test_many_nodes_global_counter();
+    test_range_init_destroy();
+    test_bulk_active_scan();
+    test_node_pool();
+    test_multithreaded_node_pool();
+    test_debounce_filter();
+    test_replay_invariants();
+#ifdef EMERGENCY_TRACE
+    test_trace_histograms();
+#endif
+#ifdef EMERGENCY_LOCK_PROFILE
+    test_lock_profile();
+#endif
+#ifdef EMERGENCY_EVENTS
+    test_event_ring();
+    test_event_replay();
+#endif
+#ifdef EMERGENCY_EXPORT
+    test_shared_memory_export();
+#endif
+#ifdef EMERGENCY_DEFERRED_LED
+    test_deferred_led();
+#endif
+#ifdef EMERGENCY_SEVERITY
+    test_severity_classes();
+#endif
+#ifdef EMERGENCY_TIMING
+    test_time_in_emergency();
+#endif
+#ifdef EMERGENCY_CONTEXTS
+    test_independent_contexts();
+    test_aggregation_tree();
+#endif
     
     // Print summary
     printf("\n=================================================\n");
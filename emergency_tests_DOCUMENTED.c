@@ -71,10 +71,10 @@ void test_node_init_right() {
 
     int8_t result = EmergencyNode_init(&node);
     TEST_ASSERT(result == 0, "Init should return 0");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should be zeroed");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should be zeroed");
 
     // Verify buffer is cleared
-    for (int i = 0; i < NUM_EMERGENCY_BUFFER; i++) {
+    for (int i = 0; i < NUM_EMERGENCY_WORDS; i++) {
         TEST_ASSERT(node.emergency_buffer[i] == 0, "Buffer should be zeroed");
     }
 
@@ -94,18 +94,20 @@ void test_raise_emergency_right() {
     // Raise emergency 5
     int8_t result = EmergencyNode_raise(&node, 5);
     TEST_ASSERT(result == 0, "Raise should succeed");
-    TEST_ASSERT(node.emergency_counter == 1, "Counter should be 1");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Counter should be 1");
     TEST_ASSERT((node.emergency_buffer[0] & (1 << 5)) != 0, "Bit 5 should be set");
 
     // Raise same emergency again
     result = EmergencyNode_raise(&node, 5);
     TEST_ASSERT(result == 0, "Raise should succeed");
-    TEST_ASSERT(node.emergency_counter == 1, "Counter should still be 1");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Counter should still be 1");
 
     // Raise different emergency
     result = EmergencyNode_raise(&node, 10);
     TEST_ASSERT(result == 0, "Raise should succeed");
-    TEST_ASSERT(node.emergency_counter == 2, "Counter should be 2");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 2, "Counter should be 2");
+
+    EmergencyNode_destroy(&node);
 
     TEST_PASS("Emergency raise");
 }
@@ -123,18 +125,18 @@ void test_solve_emergency_right() {
     // Setup: raise two emergencies
     EmergencyNode_raise(&node, 5);
     EmergencyNode_raise(&node, 10);
-    TEST_ASSERT(node.emergency_counter == 2, "Counter should be 2");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 2, "Counter should be 2");
 
     // Solve first emergency
     int8_t result = EmergencyNode_solve(&node, 5);
     TEST_ASSERT(result == 0, "Solve should succeed");
-    TEST_ASSERT(node.emergency_counter == 1, "Counter should be 1");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Counter should be 1");
     TEST_ASSERT((node.emergency_buffer[0] & (1 << 5)) == 0, "Bit 5 should be cleared");
 
     // Solve second emergency
     result = EmergencyNode_solve(&node, 10);
     TEST_ASSERT(result == 0, "Solve should succeed");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should be 0");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should be 0");
 
     TEST_PASS("Emergency solve");
 }
@@ -158,13 +160,13 @@ void test_raise_solve_inverse() {
         EmergencyNode_raise(&node, i);
     }
 
-    TEST_ASSERT(node.emergency_counter == 20, "Counter should be 20");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 20, "Counter should be 20");
 
     for (uint8_t i = 0; i < 20; i++) {
         EmergencyNode_solve(&node, i);
     }
 
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should return to 0");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should return to 0");
     TEST_PASS("Raise/solve inverse relationship");
 }
 
@@ -183,17 +185,17 @@ void test_emergency_state_cross_check() {
     EmergencyNode_init(&node);
 
     // Verify that node counter is 0
-    TEST_ASSERT(node.emergency_counter == 0, "Node counter should be 0 initially");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Node counter should be 0 initially");
 
     // Raise emergency and check state
     EmergencyNode_raise(&node, 7);
     int8_t state = EmergencyNode_is_emergency_state(&node);
     TEST_ASSERT(state != 0, "Should be in emergency state after raise");
-    TEST_ASSERT(node.emergency_counter == 1, "Node counter should be 1 after raise");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 1, "Node counter should be 1 after raise");
 
     // Solve and verify state cleared
     EmergencyNode_solve(&node, 7);
-    TEST_ASSERT(node.emergency_counter == 0, "Node counter should be 0 after solve");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Node counter should be 0 after solve");
 
     TEST_PASS("Emergency state cross-check");
 }
@@ -223,6 +225,8 @@ void test_boundary_conditions_error() {
     result = EmergencyNode_solve(&node, 64);
     TEST_ASSERT(result == -1, "Solve ID 64 should fail");
 
+    EmergencyNode_destroy(&node);
+
     TEST_PASS("Boundary condition handling");
 }
 
@@ -238,7 +242,7 @@ void test_solve_nonexistent_error() {
     // Solving emergency that was never raised should be safe
     int8_t result = EmergencyNode_solve(&node, 5);
     TEST_ASSERT(result == 0, "Solving non-existent should succeed gracefully");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should remain 0");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should remain 0");
 
     TEST_PASS("Solve non-existent emergency");
 }
@@ -256,12 +260,12 @@ void test_destroy_with_active_emergencies() {
     // Setup: create active emergencies
     EmergencyNode_raise(&node, 5);
     EmergencyNode_raise(&node, 10);
-    TEST_ASSERT(node.emergency_counter == 2, "Counter should be 2");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 2, "Counter should be 2");
 
     // Destroy should clean up everything
     int8_t result = EmergencyNode_destroy(&node);
     TEST_ASSERT(result == 0, "Destroy should succeed");
-    TEST_ASSERT(node.emergency_counter == 0, "Counter should be cleared");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "Counter should be cleared");
 
     TEST_PASS("Destroy with active emergencies");
 }
@@ -289,7 +293,7 @@ void test_performance_many_operations() {
         EmergencyNode_solve(&node, id);
     }
 
-    TEST_ASSERT(node.emergency_counter == 0, "All emergencies should be solved");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "All emergencies should be solved");
     TEST_PASS("Performance with many operations");
 }
 
@@ -299,7 +303,7 @@ void test_performance_many_operations() {
 
 // Thread test data structure
 typedef struct {
-    EmergencyNode_t* node;
+    EmergencyNodeAtomic_t* node;
     int thread_id;
     int iterations;
 } ThreadTestData;
@@ -313,7 +317,7 @@ void* thread_raise_worker(void* arg) {
 
     for (int i = 0; i < data->iterations; i++) {
         uint8_t emergency_id = (data->thread_id * 8 + (i % 8)) % 64;
-        EmergencyNode_raise(data->node, emergency_id);
+        EmergencyNodeAtomic_raise(data->node, emergency_id);
         usleep(10); // Small delay to increase contention
     }
 
@@ -329,7 +333,7 @@ void* thread_solve_worker(void* arg) {
 
     for (int i = 0; i < data->iterations; i++) {
         uint8_t emergency_id = (data->thread_id * 8 + (i % 8)) % 64;
-        EmergencyNode_solve(data->node, emergency_id);
+        EmergencyNodeAtomic_solve(data->node, emergency_id);
         usleep(10);
     }
 
@@ -343,8 +347,8 @@ void* thread_solve_worker(void* arg) {
 void test_multithreaded_raise() {
     printf("\n[MULTITHREADED] Testing concurrent raise operations...\n");
 
-    EmergencyNode_t node;
-    EmergencyNode_init(&node);
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
 
     const int NUM_THREADS = 4;
     const int ITERATIONS = 100;
@@ -365,8 +369,11 @@ void test_multithreaded_raise() {
         pthread_join(threads[i], NULL);
     }
 
-    TEST_ASSERT(node.emergency_counter > 0, "Some emergencies should be raised");
-    TEST_ASSERT(node.emergency_counter <= 64, "Counter should not exceed max emergencies");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) == 32, "Every raised emergency should be counted");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) <= 64, "Counter should not exceed max emergencies");
+
+    EmergencyNodeAtomic_destroy(&node);
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 0, "Destroy should release the global counter");
 
     TEST_PASS("Multithreaded raise operations");
 }
@@ -378,8 +385,8 @@ void test_multithreaded_raise() {
 void test_multithreaded_raise_and_solve() {
     printf("\n[MULTITHREADED] Testing concurrent raise and solve...\n");
 
-    EmergencyNode_t node;
-    EmergencyNode_init(&node);
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
 
     const int NUM_THREADS = 8;
     const int ITERATIONS = 50;
@@ -405,7 +412,10 @@ void test_multithreaded_raise_and_solve() {
     }
 
     // System should remain consistent
-    TEST_ASSERT(node.emergency_counter <= 64, "Counter should be valid");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) <= 64, "Counter should be valid");
+
+    EmergencyNodeAtomic_destroy(&node);
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 0, "Destroy should release the global counter");
 
     TEST_PASS("Multithreaded raise and solve");
 }
@@ -421,9 +431,9 @@ void* thread_stress_worker(void* arg) {
         uint8_t emergency_id = rand() % 64;
 
         if (rand() % 2) {
-            EmergencyNode_raise(data->node, emergency_id);
+            EmergencyNodeAtomic_raise(data->node, emergency_id);
         } else {
-            EmergencyNode_solve(data->node, emergency_id);
+            EmergencyNodeAtomic_solve(data->node, emergency_id);
         }
     }
 
@@ -437,8 +447,8 @@ void* thread_stress_worker(void* arg) {
 void test_multithreaded_stress() {
     printf("\n[MULTITHREADED] Stress testing with random operations...\n");
 
-    EmergencyNode_t node;
-    EmergencyNode_init(&node);
+    EmergencyNodeAtomic_t node;
+    EmergencyNodeAtomic_init(&node);
 
     const int NUM_THREADS = 10;
     const int ITERATIONS = 1000;
@@ -457,7 +467,10 @@ void test_multithreaded_stress() {
         pthread_join(threads[i], NULL);
     }
 
-    TEST_ASSERT(node.emergency_counter <= 64, "Counter should remain valid after stress");
+    TEST_ASSERT(EmergencyNodeAtomic_counter(&node) <= 64, "Counter should remain valid after stress");
+
+    EmergencyNodeAtomic_destroy(&node);
+    TEST_ASSERT(EmergencyNodeAtomic_is_emergency_state(&node) == 0, "Destroy should release the global counter");
 
     TEST_PASS("Multithreaded stress test");
 }
@@ -481,11 +494,11 @@ void test_all_emergencies_simultaneously() {
         EmergencyNode_raise(&node, i);
     }
 
-    TEST_ASSERT(node.emergency_counter == 64, "All 64 emergencies should be active");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 64, "All 64 emergencies should be active");
 
     // Verify all bits are set
-    for (int i = 0; i < NUM_EMERGENCY_BUFFER; i++) {
-        TEST_ASSERT(node.emergency_buffer[i] == 0xFF, "All bits in buffer should be set");
+    for (int i = 0; i < NUM_EMERGENCY_WORDS; i++) {
+        TEST_ASSERT(node.emergency_buffer[i] == UINT64_MAX, "All bits in buffer should be set");
     }
 
     // Solve all
@@ -493,7 +506,7 @@ void test_all_emergencies_simultaneously() {
         EmergencyNode_solve(&node, i);
     }
 
-    TEST_ASSERT(node.emergency_counter == 0, "All emergencies should be solved");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "All emergencies should be solved");
 
     TEST_PASS("All emergencies simultaneously");
 }
@@ -514,13 +527,13 @@ void test_byte_boundary_emergencies() {
         EmergencyNode_raise(&node, boundaries[i]);
     }
 
-    TEST_ASSERT(node.emergency_counter == sizeof(boundaries), "All boundary emergencies should be raised");
+    TEST_ASSERT(EmergencyNode_counter(&node) == sizeof(boundaries), "All boundary emergencies should be raised");
 
     for (int i = 0; i < sizeof(boundaries); i++) {
         EmergencyNode_solve(&node, boundaries[i]);
     }
 
-    TEST_ASSERT(node.emergency_counter == 0, "All boundary emergencies should be solved");
+    TEST_ASSERT(EmergencyNode_counter(&node) == 0, "All boundary emergencies should be solved");
 
     TEST_PASS("Byte boundary emergencies");
 }
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <type_traits>
+#include <utility>
+// an includer's own definition of restrict must survive the header
+#define restrict __restrict__
+#include "emergency_module.hpp"
+#ifndef restrict
+#error "emergency_module.hpp dropped the includer's restrict"
+#endif
+#undef restrict
+
+/*
+ * Tests of the C++ layer (emergency_module.hpp); the C API itself is covered
+ * by emergency_tests.c.
+ */
+
+using OverTemp = emergency::Exception<3>;
+using UnderVoltage = emergency::Exception<7>;
+using Stall = emergency::Exception<12>;
+
+// Test statistics
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// Test result tracking
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            printf("  ❌ FAILED: %s\n", message); \
+            tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define TEST_PASS(name) \
+    do { \
+        printf("  ✅ PASSED: %s\n", name); \
+        tests_passed++; \
+    } while(0)
+
+// whether each member accepts T on a node of ids below 8
+template <class T, class = void>
+struct can_raise : std::false_type {};
+
+template <class T>
+struct can_raise<T, std::void_t<decltype(std::declval<emergency::EmergencyNode<8>&>().raise<T>())>> : std::true_type {};
+
+template <class T, class = void>
+struct can_solve : std::false_type {};
+
+template <class T>
+struct can_solve<T, std::void_t<decltype(std::declval<emergency::EmergencyNode<8>&>().solve(T{}))>> : std::true_type {};
+
+template <class T, class = void>
+struct can_query : std::false_type {};
+
+template <class T>
+struct can_query<T, std::void_t<decltype(std::declval<const emergency::EmergencyNode<8>&>().is_raised<T>())>> : std::true_type {};
+
+template <class T, class = void>
+struct can_scope : std::false_type {};
+
+template <class T>
+struct can_scope<T, std::void_t<decltype(std::declval<emergency::EmergencyNode<8>&>().scoped<T>())>> : std::true_type {};
+
+static_assert(can_raise<OverTemp>::value && can_raise<UnderVoltage>::value, "Ids below the node should be accepted");
+static_assert(!can_raise<Stall>::value, "Id past the node should not be raisable");
+static_assert(!can_solve<Stall>::value, "Id past the node should not be solvable");
+static_assert(!can_query<Stall>::value, "Id past the node should not be queryable");
+static_assert(!can_scope<Stall>::value, "Id past the node should not be scopable");
+
+static_assert(OverTemp::mask == 0x8, "Exception masks should be constants");
+static_assert(sizeof(emergency::EmergencyNode<>) == sizeof(EmergencyNode_t), "The wrapper should add nothing to the node");
+
+void test_typed_raise_solve() {
+    printf("\n[RIGHT] Testing typed raise and solve...\n");
+
+    emergency::EmergencyNode<16> motor;
+    const int32_t base = emergency::global_counter();
+
+    motor.raise<OverTemp>();
+    TEST_ASSERT(motor.is_raised<OverTemp>(), "Raise should set the exception");
+    TEST_ASSERT(motor.counter() == 1, "Counter should count the exception");
+    TEST_ASSERT(emergency::global_counter() == base + 1, "Node edge should reach the global counter");
+    motor.raise<OverTemp>();
+    TEST_ASSERT(motor.counter() == 1, "Re-raise should change nothing");
+
+    motor.raise(UnderVoltage{}, Stall{});
+    TEST_ASSERT(motor.counter() == 3, "Batch raise should set every exception");
+    TEST_ASSERT(emergency::global_counter() == base + 1, "Batch raise should not count the node again");
+
+    motor.solve<OverTemp, Stall>();
+    TEST_ASSERT(!motor.is_raised<Stall>() && motor.is_raised<UnderVoltage>(), "Batch solve should clear its exceptions only");
+    motor.solve(UnderVoltage{});
+    TEST_ASSERT(emergency::global_counter() == base, "Clear node should leave the global counter");
+    TEST_ASSERT(!motor.is_emergency_state(), "Clear system should not be in emergency");
+
+    TEST_PASS("Typed raise and solve");
+}
+
+void test_compile_time_bounds() {
+    printf("\n[EDGE CASE] Testing compile-time exception bounds...\n");
+
+    // ids past the node are rejected at namespace scope above; the last id inside it must work
+    emergency::EmergencyNode<8> valve;
+    valve.raise<UnderVoltage>();
+    TEST_ASSERT(valve.is_raised<UnderVoltage>() && valve.counter() == 1, "Highest id of the node should be raised");
+    valve.solve(UnderVoltage{});
+    TEST_ASSERT(valve.counter() == 0, "Highest id of the node should be solved");
+
+    TEST_PASS("Compile-time exception bounds");
+}
+
+void test_scoped_emergency() {
+    printf("\n[RIGHT] Testing scoped emergencies...\n");
+
+    emergency::EmergencyNode<> pump;
+    {
+        auto guard = pump.scoped<OverTemp, UnderVoltage>();
+        TEST_ASSERT(pump.counter() == 2, "Guard should raise its exceptions");
+        TEST_ASSERT(emergency::global_state(), "Guard should put the system in emergency");
+
+        auto moved = std::move(guard);
+        TEST_ASSERT(pump.counter() == 2, "Move should not solve");
+    }
+    TEST_ASSERT(pump.counter() == 0, "Guard should solve on destruction");
+
+    auto early = pump.scoped<Stall>();
+    early.reset();
+    TEST_ASSERT(!pump.is_raised<Stall>(), "Reset should solve early");
+    early = pump.scoped<OverTemp>();
+    TEST_ASSERT(pump.is_raised<OverTemp>(), "Assigned guard should hold its exception");
+    early = pump.scoped<Stall>();
+    TEST_ASSERT(!pump.is_raised<OverTemp>() && pump.is_raised<Stall>(), "Assignment should solve the old exception");
+    early.reset();
+    TEST_ASSERT(!emergency::global_state(), "Nothing should be left in emergency");
+
+    TEST_PASS("Scoped emergencies");
+}
+
+int main() {
+    printf("=================================================\n");
+    printf("  Emergency Module C++ Layer Tests\n");
+    printf("=================================================\n");
+
+    EmergencyNode_class_init();
+    test_typed_raise_solve();
+    test_compile_time_bounds();
+    test_scoped_emergency();
+
+    printf("\n=================================================\n");
+    printf("  ✅ Passed: %d\n", tests_passed);
+    printf("  ❌ Failed: %d\n", tests_failed);
+    printf("=================================================\n");
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+#include "./emergency_timing.h"
+
+#ifdef EMERGENCY_TIMING
+
+#include "./emergency_clock.h"
+#include "./emergency_internal.h"
+#include "./emergency_spinlock.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+//private
+
+// per exception; since is 0 while the exception is clear
+typedef struct {
+  atomic_uint_fast64_t since[64];
+  atomic_uint_fast64_t total[64];
+  atomic_uint_fast64_t max[64];
+  atomic_uint_least32_t activations[64];
+}TimingStats;
+
+_Static_assert(EMERGENCY_TIMING_BUCKETS > 0 && (EMERGENCY_TIMING_BUCKETS & (EMERGENCY_TIMING_BUCKETS - 1)) == 0,
+    "timing buckets must be a power of two");
+_Static_assert(EMERGENCY_TIMING_NODES < 256, "a bucket counts its tracked nodes in one byte");
+
+/*
+ * The tracked node pointers sit together, apart from the stats, so the
+ * lookup on a tracked edge reads a line or two; the bucket counts in front
+ * of them keep untracked edges to one load. Under the table lock a slot is
+ * claimed, its stats cleared, its bucket counted, and only then its node
+ * published.
+ */
+static struct{
+  atomic_uint_least8_t bucket[EMERGENCY_TIMING_BUCKETS] __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  // track and untrack, never the edges; one node can only claim one slot
+  EmergencySpinlock_t table_lock;
+  uint8_t claimed[EMERGENCY_TIMING_NODES];
+  const void* _Atomic node[EMERGENCY_TIMING_NODES] __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+  atomic_uint_fast8_t calibrated;
+  uint64_t calibration_ns;
+  uint64_t calibration_cycles;
+  TimingStats stats[EMERGENCY_TIMING_NODES] __attribute__((__aligned__(EMERGENCY_CACHE_LINE)));
+}TIMING;
+
+static inline uint32_t _bucket_of(const void* const p_node)
+{
+  // Fibonacci hashing of the address without its alignment bits
+  const uint64_t key = (uint64_t) (uintptr_t) p_node >> 3;
+  return (uint32_t) ((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (EMERGENCY_TIMING_BUCKETS - 1);
+}
+
+// field by field: a reader that looked the slot up before its last untrack may still be loading
+static void _stats_reset(TimingStats* const p_stats)
+{
+  for (uint8_t e = 0; e < 64; e++)
+  {
+    atomic_store_explicit(&p_stats->since[e], 0, memory_order_relaxed);
+    atomic_store_explicit(&p_stats->total[e], 0, memory_order_relaxed);
+    atomic_store_explicit(&p_stats->max[e], 0, memory_order_relaxed);
+    atomic_store_explicit(&p_stats->activations[e], 0, memory_order_relaxed);
+  }
+}
+
+static int16_t _slot_of(const void* const p_node)
+{
+  for (uint16_t i = 0; i < EMERGENCY_TIMING_NODES; i++)
+  {
+    if (atomic_load_explicit(&TIMING.node[i], memory_order_acquire) == p_node)
+    {
+      return (int16_t) i;
+    }
+  }
+  return -1;
+}
+
+static inline TimingStats* _stats_of(const void* const p_node)
+{
+  if (!atomic_load_explicit(&TIMING.bucket[_bucket_of(p_node)], memory_order_relaxed))
+  {
+    return NULL;
+  }
+  const int16_t slot = _slot_of(p_node);
+  return slot < 0 ? NULL : &TIMING.stats[slot];
+}
+
+static void _calibrate_start(void)
+{
+  uint_fast8_t expected = 0;
+  if (atomic_compare_exchange_strong(&TIMING.calibrated, &expected, 1))
+  {
+    TIMING.calibration_ns = EmergencyClock_now_ns();
+    TIMING.calibration_cycles = EmergencyClock_cycles();
+    atomic_store(&TIMING.calibrated, 2);
+  }
+}
+
+//internal
+
+void EmergencyTiming_raised(const void* const p_node, uint64_t bits)
+{
+  TimingStats* const stats = _stats_of(p_node);
+  if (!stats || !bits)
+  {
+    return;
+  }
+
+  const uint64_t now = EmergencyClock_cycles();
+  while (bits)
+  {
+    atomic_store_explicit(&stats->since[__builtin_ctzll(bits)], now ? now : 1, memory_order_relaxed);
+    bits &= bits - 1;
+  }
+}
+
+void EmergencyTiming_solved(const void* const p_node, uint64_t bits)
+{
+  TimingStats* const stats = _stats_of(p_node);
+  if (!stats || !bits)
+  {
+    return;
+  }
+
+  const uint64_t now = EmergencyClock_cycles();
+  while (bits)
+  {
+    const uint8_t e = (uint8_t) __builtin_ctzll(bits);
+    bits &= bits - 1;
+    const uint64_t since = atomic_exchange_explicit(&stats->since[e], 0, memory_order_relaxed);
+    if (!since)
+    {
+      // the raise of this activation has not stored its timestamp yet
+      continue;
+    }
+
+    const uint64_t active = now - since;
+    atomic_fetch_add_explicit(&stats->total[e], active, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->activations[e], 1, memory_order_relaxed);
+    uint_fast64_t max = atomic_load_explicit(&stats->max[e], memory_order_relaxed);
+    while (active > max && !atomic_compare_exchange_weak_explicit(&stats->max[e], &max, active,
+        memory_order_relaxed, memory_order_relaxed));
+  }
+}
+
+//public
+
+int8_t EmergencyTiming_track(const void* const p_node)
+{
+  int8_t result = -1;
+  EmergencySpinlock_lock(&TIMING.table_lock);
+  for (uint16_t i = 0; i < EMERGENCY_TIMING_NODES && _slot_of(p_node) < 0; i++)
+  {
+    if (TIMING.claimed[i])
+    {
+      continue;
+    }
+
+    TIMING.claimed[i] = 1;
+    _stats_reset(&TIMING.stats[i]);
+    _calibrate_start();
+    atomic_fetch_add(&TIMING.bucket[_bucket_of(p_node)], 1);
+    atomic_store_explicit(&TIMING.node[i], p_node, memory_order_release);
+    result = 0;
+    break;
+  }
+  EmergencySpinlock_unlock(&TIMING.table_lock);
+
+  return result;
+}
+
+int8_t EmergencyTiming_untrack(const void* const p_node)
+{
+  EmergencySpinlock_lock(&TIMING.table_lock);
+  const int16_t slot = _slot_of(p_node);
+  if (slot >= 0)
+  {
+    atomic_store(&TIMING.node[slot], NULL);
+    atomic_fetch_sub(&TIMING.bucket[_bucket_of(p_node)], 1);
+    TIMING.claimed[slot] = 0;
+  }
+  EmergencySpinlock_unlock(&TIMING.table_lock);
+
+  return slot >= 0 ? 0 : -1;
+}
+
+int8_t EmergencyTiming_stats(const void* const p_node, const uint8_t exception,
+    EmergencyTimingStats_t* const restrict p_out)
+{
+  const int16_t slot = _slot_of(p_node);
+  if (slot < 0 || exception >= 64)
+  {
+    return -1;
+  }
+
+  const TimingStats* const stats = &TIMING.stats[slot];
+  const uint64_t since = atomic_load_explicit(&stats->since[exception], memory_order_relaxed);
+  p_out->activations = atomic_load_explicit(&stats->activations[exception], memory_order_relaxed);
+  p_out->total_cycles = atomic_load_explicit(&stats->total[exception], memory_order_relaxed);
+  p_out->max_cycles = atomic_load_explicit(&stats->max[exception], memory_order_relaxed);
+  p_out->active_cycles = since ? EmergencyClock_cycles() - since : 0;
+
+  return 0;
+}
+
+uint64_t EmergencyTiming_cycles_to_ns(const uint64_t cycles)
+{
+  if (atomic_load(&TIMING.calibrated) != 2)
+  {
+    return cycles;
+  }
+
+  const uint64_t elapsed_cycles = EmergencyClock_cycles() - TIMING.calibration_cycles;
+  const uint64_t elapsed_ns = EmergencyClock_now_ns() - TIMING.calibration_ns;
+  if (!elapsed_cycles)
+  {
+    return cycles;
+  }
+
+  return (uint64_t) ((double) cycles * (double) elapsed_ns / (double) elapsed_cycles);
+}
+
+#endif // EMERGENCY_TIMING
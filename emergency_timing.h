@@ -0,0 +1,62 @@
+#ifndef __EMERGENCY_TIMING__
+#define __EMERGENCY_TIMING__
+
+#include <stdint.h>
+
+/*
+ * Time-in-emergency accounting, compiled in with -DEMERGENCY_TIMING.
+ *
+ * Nodes (plain or atomic) are tracked in a side table of
+ * EMERGENCY_TIMING_NODES entries, so EmergencyNode_t keeps its size. For a
+ * tracked node the 0->1 edge of an exception stores a timestamp from
+ * EmergencyClock_cycles; the 1->0 edge (solve, or destroy) adds the elapsed
+ * cycles to the exception's total. Re-raising a raised exception and
+ * solving a clear one read no clock. Every edge first loads one of
+ * EMERGENCY_TIMING_BUCKETS counters, picked by hashing the node address, of
+ * the tracked nodes in that bucket; only edges of nodes whose bucket is not
+ * empty, so tracked nodes and the odd untracked node sharing their bucket,
+ * scan the table.
+ *
+ * Track a node before it is used and untrack it once it is idle. On an
+ * atomic node whose raise and solve of one exception race on two threads,
+ * that one activation may go uncounted.
+ */
+
+#ifdef EMERGENCY_TIMING
+
+#ifndef EMERGENCY_TIMING_NODES
+#define EMERGENCY_TIMING_NODES 16
+#endif
+
+// node address filter in front of the table, one byte per bucket
+#ifndef EMERGENCY_TIMING_BUCKETS
+#define EMERGENCY_TIMING_BUCKETS 64
+#endif
+
+typedef struct {
+  // completed activations, and the cycles they were active in total / at most
+  uint32_t activations;
+  uint64_t total_cycles;
+  uint64_t max_cycles;
+  // cycles the running activation has been active, 0 when the exception is clear
+  uint64_t active_cycles;
+}EmergencyTimingStats_t;
+
+// -1 when the table is full or the node is tracked already; stats start at zero
+int8_t EmergencyTiming_track(const void* const p_node)__attribute__((__nonnull__(1)));
+
+int8_t EmergencyTiming_untrack(const void* const p_node)__attribute__((__nonnull__(1)));
+
+// -1 for untracked nodes and exceptions above 63
+int8_t EmergencyTiming_stats(const void* const p_node, const uint8_t exception,
+    EmergencyTimingStats_t* const restrict p_out)__attribute__((__nonnull__(1, 3)));
+
+/*
+ * Cycles in ns, calibrated against CLOCK_MONOTONIC over the time since the
+ * first node was tracked: the longer the program ran, the closer the ratio.
+ */
+uint64_t EmergencyTiming_cycles_to_ns(const uint64_t cycles);
+
+#endif // EMERGENCY_TIMING
+
+#endif // !__EMERGENCY_TIMING__
@@ -0,0 +1,268 @@
+#include "./emergency_trace.h"
+
+#ifdef EMERGENCY_TRACE
+
+#include "./emergency_clock.h"
+#include "./emergency_internal.h"
+#include <stdatomic.h>
+#include <string.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+//private
+
+/*
+ * Only the owning thread writes its histograms, so a sample is a relaxed
+ * load and store per field instead of a locked read-modify-write; the fields
+ * are atomic so a concurrent snapshot never reads a torn value.
+ */
+typedef struct {
+  atomic_uint_fast64_t max;
+  atomic_uint_fast64_t buckets[EMERGENCY_TRACE_BUCKETS];
+}TraceHistogram;
+
+typedef struct {
+  TraceHistogram histogram[EMERGENCY_TRACE_HISTOGRAMS];
+} __attribute__((__aligned__(EMERGENCY_CACHE_LINE))) TraceThread;
+
+/*
+ * A thread claims a free slot on its first sample and frees it when it
+ * exits (a pthread key destructor), so the limit is on threads alive at one
+ * time. The slot keeps its histograms: the next owner adds to them, and
+ * snapshots merge every slot ever used.
+ */
+static TraceThread TRACE_THREADS[EMERGENCY_TRACE_MAX_THREADS];
+static atomic_uint_fast8_t trace_slot_taken[EMERGENCY_TRACE_MAX_THREADS];
+// slots below this index have been held at some point
+static atomic_uint trace_slots_used;
+static atomic_uint trace_untracked_threads;
+
+static _Thread_local TraceThread* trace_self;
+static _Thread_local uint8_t trace_untracked;
+static _Thread_local uint64_t trace_raise_start;
+static _Thread_local uint64_t trace_led_at;
+
+static inline uint32_t _bucket_index(const uint64_t value)
+{
+  if (value < (UINT64_C(1) << EMERGENCY_TRACE_SUB_BITS))
+  {
+    return (uint32_t) value;
+  }
+
+  const uint32_t magnitude = 63 - (uint32_t) __builtin_clzll(value);
+  const uint32_t shift = magnitude - EMERGENCY_TRACE_SUB_BITS;
+  const uint32_t sub = (uint32_t) (value >> shift) & ((1u << EMERGENCY_TRACE_SUB_BITS) - 1);
+  return ((shift + 1) << EMERGENCY_TRACE_SUB_BITS) + sub;
+}
+
+#ifndef _WIN32
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+
+// runs on the exiting thread, so it can also stop that thread's later samples
+static void _release_slot(void* const p_slot)
+{
+  trace_self = NULL;
+  trace_untracked = 1;
+  atomic_store_explicit(&trace_slot_taken[(TraceThread*) p_slot - TRACE_THREADS], 0, memory_order_release);
+}
+
+static void _create_key(void)
+{
+  pthread_key_create(&trace_key, _release_slot);
+}
+#endif
+
+static TraceThread* _claim_slot(void)
+{
+  for (uint32_t slot = 0; slot < EMERGENCY_TRACE_MAX_THREADS; slot++)
+  {
+    uint_fast8_t expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(&trace_slot_taken[slot], &expected, 1,
+        memory_order_acquire, memory_order_relaxed))
+    {
+      continue;
+    }
+
+    unsigned used = atomic_load(&trace_slots_used);
+    while (used <= slot && !atomic_compare_exchange_weak(&trace_slots_used, &used, slot + 1));
+#ifndef _WIN32
+    pthread_once(&trace_key_once, _create_key);
+    pthread_setspecific(trace_key, &TRACE_THREADS[slot]);
+#endif
+    return &TRACE_THREADS[slot];
+  }
+  return NULL;
+}
+
+static TraceThread* _trace_thread(void)
+{
+  if (!trace_self && !trace_untracked)
+  {
+    trace_self = _claim_slot();
+    if (!trace_self)
+    {
+      trace_untracked = 1;
+      atomic_fetch_add(&trace_untracked_threads, 1);
+    }
+  }
+  return trace_self;
+}
+
+static void _record(const EmergencyTraceHistogram_t histogram, const uint64_t value)
+{
+  TraceThread* const self = _trace_thread();
+  if (!self)
+  {
+    return;
+  }
+
+  TraceHistogram* const h = &self->histogram[histogram];
+  atomic_uint_fast64_t* const bucket = &h->buckets[_bucket_index(value)];
+  atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+  if (value > atomic_load_explicit(&h->max, memory_order_relaxed))
+  {
+    atomic_store_explicit(&h->max, value, memory_order_relaxed);
+  }
+}
+
+//internal
+
+void EmergencyTrace_raise_begin(void)
+{
+  trace_raise_start = EmergencyClock_cycles();
+  trace_led_at = 0;
+}
+
+void EmergencyTrace_led_on(void)
+{
+  // LED writes outside a raise (a solve reconciling the LED) have no start
+  if (trace_raise_start)
+  {
+    trace_led_at = EmergencyClock_cycles();
+  }
+}
+
+void EmergencyTrace_raise_end(void)
+{
+  const uint64_t now = EmergencyClock_cycles();
+  if (trace_led_at)
+  {
+    _record(EMERGENCY_TRACE_RAISE_TO_LED, trace_led_at - trace_raise_start);
+  }
+  _record(EMERGENCY_TRACE_RAISE, now - trace_raise_start);
+  trace_raise_start = 0;
+  trace_led_at = 0;
+}
+
+void EmergencyTrace_spin(const uint32_t spins)
+{
+  _record(EMERGENCY_TRACE_SPIN, spins);
+}
+
+//public
+
+int8_t EmergencyTrace_snapshot(const EmergencyTraceHistogram_t histogram,
+    EmergencyTraceSnapshot_t* const restrict p_out)
+{
+  memset(p_out, 0, sizeof(*p_out));
+  if (histogram >= EMERGENCY_TRACE_HISTOGRAMS)
+  {
+    return -1;
+  }
+
+  p_out->untracked_threads = atomic_load(&trace_untracked_threads);
+
+  // slots freed by exited threads keep their samples, so every slot ever used is merged
+  const uint32_t used = atomic_load(&trace_slots_used);
+  for (uint32_t t = 0; t < used; t++)
+  {
+    p_out->threads += atomic_load_explicit(&trace_slot_taken[t], memory_order_relaxed) != 0;
+    TraceHistogram* const h = &TRACE_THREADS[t].histogram[histogram];
+    for (uint32_t b = 0; b < EMERGENCY_TRACE_BUCKETS; b++)
+    {
+      const uint64_t n = atomic_load_explicit(&h->buckets[b], memory_order_relaxed);
+      p_out->buckets[b] += n;
+      // count is the bucket sum, so percentiles stay consistent with a racing writer
+      p_out->count += n;
+    }
+    const uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    if (max > p_out->max)
+    {
+      p_out->max = max;
+    }
+  }
+
+  return 0;
+}
+
+uint64_t EmergencyTrace_bucket_value(const uint32_t bucket)
+{
+  if (bucket < (1u << EMERGENCY_TRACE_SUB_BITS))
+  {
+    return bucket;
+  }
+
+  const uint32_t shift = (bucket >> EMERGENCY_TRACE_SUB_BITS) - 1;
+  const uint64_t sub = bucket & ((1u << EMERGENCY_TRACE_SUB_BITS) - 1);
+  return ((UINT64_C(1) << EMERGENCY_TRACE_SUB_BITS) | sub) << shift;
+}
+
+uint64_t EmergencyTrace_percentile(const EmergencyTraceSnapshot_t* const restrict p_self,
+    const uint32_t per_mille)
+{
+  if (!p_self->count)
+  {
+    return 0;
+  }
+
+  const uint64_t rank = per_mille >= 1000 ? p_self->count : (p_self->count * per_mille) / 1000 + 1;
+  uint64_t seen = 0;
+  for (uint32_t b = 0; b < EMERGENCY_TRACE_BUCKETS; b++)
+  {
+    seen += p_self->buckets[b];
+    if (seen >= rank)
+    {
+      return EmergencyTrace_bucket_value(b);
+    }
+  }
+  return p_self->max;
+}
+
+void EmergencyTrace_dump(FILE* const out)
+{
+  static const char* const names[EMERGENCY_TRACE_HISTOGRAMS] = {
+    "raise_to_led", "raise", "spin",
+  };
+
+  for (uint32_t i = 0; i < EMERGENCY_TRACE_HISTOGRAMS; i++)
+  {
+    EmergencyTraceSnapshot_t snapshot;
+    EmergencyTrace_snapshot((EmergencyTraceHistogram_t) i, &snapshot);
+    fprintf(out, "%-12s count %llu p50 %llu p99 %llu p99.9 %llu max %llu\n", names[i],
+        (unsigned long long) snapshot.count,
+        (unsigned long long) EmergencyTrace_percentile(&snapshot, 500),
+        (unsigned long long) EmergencyTrace_percentile(&snapshot, 990),
+        (unsigned long long) EmergencyTrace_percentile(&snapshot, 999),
+        (unsigned long long) snapshot.max);
+  }
+}
+
+void EmergencyTrace_reset(void)
+{
+  for (uint32_t t = 0; t < EMERGENCY_TRACE_MAX_THREADS; t++)
+  {
+    for (uint32_t i = 0; i < EMERGENCY_TRACE_HISTOGRAMS; i++)
+    {
+      TraceHistogram* const h = &TRACE_THREADS[t].histogram[i];
+      atomic_store(&h->max, 0);
+      for (uint32_t b = 0; b < EMERGENCY_TRACE_BUCKETS; b++)
+      {
+        atomic_store(&h->buckets[b], 0);
+      }
+    }
+  }
+}
+
+#endif // EMERGENCY_TRACE
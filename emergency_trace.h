@@ -0,0 +1,76 @@
+#ifndef __EMERGENCY_TRACE__
+#define __EMERGENCY_TRACE__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Raise-to-LED latency instrumentation, compiled in with -DEMERGENCY_TRACE.
+ *
+ * Every thread records into its own histograms, so recording is a few plain
+ * stores on lines no other thread writes. Values are kept in log-linear
+ * buckets (HDR style: EMERGENCY_TRACE_SUB_BITS bits below the leading one,
+ * about 12% relative error) and measured in EmergencyClock_cycles ticks.
+ *
+ *   RAISE_TO_LED  from entering the raise slow path to this raise writing 1
+ *                 to emergency_led
+ *   RAISE         the full raise slow path, whether or not the LED changed
+ *   SPIN          failed lock attempts per acquisition (spinlock build) or
+ *                 extra LED reconcile passes (lock-free builds)
+ *
+ * Each recording thread holds one of EMERGENCY_TRACE_MAX_THREADS slots from
+ * its first sample until it exits, when the slot goes back to the pool with
+ * its samples kept (on POSIX; Windows threads keep their slot). A thread
+ * that finds every slot held by a live thread is never recorded; it is
+ * counted in untracked_threads.
+ *
+ * Without EMERGENCY_TRACE none of this exists and the hooks compile to nothing.
+ */
+
+#ifdef EMERGENCY_TRACE
+
+#ifndef EMERGENCY_TRACE_MAX_THREADS
+#define EMERGENCY_TRACE_MAX_THREADS 32
+#endif
+
+#define EMERGENCY_TRACE_SUB_BITS 3
+#define EMERGENCY_TRACE_BUCKETS ((64 - EMERGENCY_TRACE_SUB_BITS + 1) << EMERGENCY_TRACE_SUB_BITS)
+
+typedef enum {
+  EMERGENCY_TRACE_RAISE_TO_LED,
+  EMERGENCY_TRACE_RAISE,
+  EMERGENCY_TRACE_SPIN,
+  EMERGENCY_TRACE_HISTOGRAMS,
+}EmergencyTraceHistogram_t;
+
+typedef struct {
+  uint64_t count;
+  uint64_t max;
+  uint64_t buckets[EMERGENCY_TRACE_BUCKETS];
+  // slots held by live threads now, and threads that found no free slot and were not recorded
+  uint32_t threads;
+  uint32_t untracked_threads;
+}EmergencyTraceSnapshot_t;
+
+// sums the histogram over all threads, exited ones included; safe while other threads keep recording
+int8_t
+EmergencyTrace_snapshot(const EmergencyTraceHistogram_t histogram,
+    EmergencyTraceSnapshot_t* const restrict)__attribute__((__nonnull__(2)));
+
+// smallest value of a bucket
+uint64_t EmergencyTrace_bucket_value(const uint32_t bucket);
+
+// lower bound of the bucket holding the per_mille-th value (0..1000)
+uint64_t
+EmergencyTrace_percentile(const EmergencyTraceSnapshot_t* const restrict,
+    const uint32_t per_mille)__attribute__((__nonnull__(1)));
+
+// count, max and p50/p99/p99.9 of every histogram
+void EmergencyTrace_dump(FILE* const out)__attribute__((__nonnull__(1)));
+
+// clears every histogram; samples recorded concurrently may survive
+void EmergencyTrace_reset(void);
+
+#endif // EMERGENCY_TRACE
+
+#endif // !__EMERGENCY_TRACE__